@@ -1,3 +1,4 @@
+import socket
 import subprocess
 
 def runTest(program, prototein):
@@ -5,6 +6,18 @@ def runTest(program, prototein):
     result = subprocess.run([filePath, prototein], stdout=subprocess.PIPE)
     maxy, duration = result.stdout.decode('utf-8').split()
     return maxy, duration
+
+# Same as runTest, but asks an already running Prototein_Server instead of starting a new process
+def runServerTest(prototein, socketPath="/tmp/prototein.sock", timeoutMs=0):
+    client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    client.connect(socketPath)
+    client.sendall(("FOLD %s %d\n" % (prototein, timeoutMs)).encode('utf-8'))
+    reply = client.makefile().readline().split()
+    client.close()
+    if reply[0] != "OK":
+        return None, None
+    status, maxy, fold, microseconds = reply
+    return maxy, microseconds
     
 
 files = ["Optimized_Parallel_Prototein.exe", "Optimized_Sequential_Prototein.exe", "Parallel_Prototein_no_output.exe"]
@@ -0,0 +1,303 @@
+/*
+This is a program that works out the answer for every prototein up to some length ahead of time and writes them all
+into a header, Prototein_Answer_Table.h, that Answer_Table_Prototein builds into itself. Short proteins then get looked
+up instead of searched, with no threads to start and nothing to enumerate.
+
+Each length is done like Sequence_Design_Prototein: the folds are enumerated once, folds with the same contact map are
+kept once, and the maps are sorted by number of contacts so each prototein can stop looking as soon as the maps left
+are too small to beat what it has. A prototein and its reverse have the same answer (the reversed fold), so only the
+one that comes first gets screened and the other is filled in from it. The proteins of each length are split across
+20 threads.
+
+The table has one entry per prototein, in order of length and then by the prototein read as a binary number (residue
+i is bit i, H is 1). Each entry is the maximum in a byte and the fold in a 32 bit word, 2 bits per move in the same
+forward/left/right numbering as the optimized versions, which is why the table stops at 17. Length 16 takes a few
+seconds to work out and makes a header of a couple of megabytes.
+
+Usage: Answer_Table_Generator [longest length, default 16] [output file, default Prototein_Answer_Table.h]
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <cstdint>
+using namespace std;
+
+#define FORWARD 0
+#define LEFT 1
+#define RIGHT 2
+
+#define WEST 0
+#define NORTH 1
+#define EAST 2
+#define SOUTH 3
+
+#define NUMTHREADS 20
+#define MAXTABLE 17
+#define DEFAULT_TABLE 16
+
+struct ContactMap {
+    uint64_t bits[4];
+    bool operator==(const ContactMap &other) const {
+        return memcmp(bits, other.bits, sizeof(bits)) == 0;
+    }
+};
+
+struct MapHash {
+    size_t operator()(const ContactMap &m) const {
+        uint64_t h = m.bits[0] * 0x9E3779B97F4A7C15ull;
+        h ^= m.bits[1] + (h << 6) + (h >> 2);
+        h ^= m.bits[2] + (h << 6) + (h >> 2);
+        h ^= m.bits[3] + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+// One distinct contact map and one of the folds that has it (2 bits per move)
+struct FoldClass {
+    ContactMap map;
+    int contacts;
+    uint32_t moves;
+};
+
+// Initializing global variables
+int protoLen;
+int pairIndex[MAXTABLE][MAXTABLE];
+vector<FoldClass> classes;
+unordered_map<ContactMap, int, MapHash> classOf;
+vector<unsigned char> maxima;
+vector<uint32_t> folds;
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+// Gives every pair of residues that could ever touch its own bit
+void buildPairIndex() {
+    int next = 0;
+    for (int i = 0; i < protoLen; i++) {
+        for (int j = 0; j < protoLen; j++) {
+            pairIndex[i][j] = -1;
+        }
+    }
+    for (int i = 0; i < protoLen; i++) {
+        for (int j = i + 3; j < protoLen; j += 2) {
+            pairIndex[i][j] = next;
+            pairIndex[j][i] = next;
+            next++;
+        }
+    }
+}
+
+void recordFold(const ContactMap &map, int contacts, uint32_t moves) {
+    if (classOf.find(map) != classOf.end()) return;
+    FoldClass c;
+    c.map = map;
+    c.contacts = contacts;
+    c.moves = moves;
+    classOf[map] = classes.size();
+    classes.push_back(c);
+}
+
+// Depth first enumeration of every fold. grid holds residue index + 1, 0 is empty.
+void enumerate(vector<int> &grid, int size, int k, int pos, int dir, bool turned, ContactMap &map, int contacts,
+               uint32_t moves) {
+    if (k == protoLen) {
+        // Folds with no contacts score 0 for every prototein, the straight line stands in for all of them
+        if (contacts > 0) recordFold(map, contacts, moves);
+        return;
+    }
+
+    const int step[4] = {-1, -size, 1, size};
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        if (!turned && m == RIGHT) continue;
+
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + step[d];
+        if (grid[next] != 0) continue;
+
+        // New contacts are with any placed residue next door other than the one we came from
+        ContactMap newMap = map;
+        int newContacts = contacts;
+        for (int n = 0; n < 4; n++) {
+            int other = grid[next + step[n]] - 1;
+            if (other < 0 || other == k - 1) continue;
+            int bit = pairIndex[other][k];
+            newMap.bits[bit >> 6] |= 1ull << (bit & 63);
+            newContacts++;
+        }
+
+        grid[next] = k + 1;
+        enumerate(grid, size, k + 1, next, d, turned || m != FORWARD, newMap, newContacts,
+                  moves | ((uint32_t) m << (2 * (k - 1))));
+        grid[next] = 0;
+    }
+}
+
+bool compareClasses(const FoldClass &a, const FoldClass &b) {
+    return a.contacts > b.contacts;
+}
+
+// The same fold read from the other end: turns in reverse order with left and right swapped, then mirrored if need be
+// so the first turn is a left
+uint32_t reverseMoves(uint32_t moves) {
+    uint32_t reversed = FORWARD;
+    for (int k = 1; k < protoLen - 1; k++) {
+        uint32_t m = (moves >> (2 * (protoLen - 1 - k))) & 3;
+        if (m != FORWARD) m = 3 - m;
+        reversed |= m << (2 * k);
+    }
+    for (int k = 1; k < protoLen - 1; k++) {
+        uint32_t m = (reversed >> (2 * k)) & 3;
+        if (m == FORWARD) continue;
+        if (m == RIGHT) {
+            uint32_t mirrored = 0;
+            for (int j = 1; j < protoLen - 1; j++) {
+                uint32_t n = (reversed >> (2 * j)) & 3;
+                if (n != FORWARD) n = 3 - n;
+                mirrored |= n << (2 * j);
+            }
+            reversed = mirrored;
+        }
+        break;
+    }
+    return reversed;
+}
+
+void *parallel_func(void *threadid){
+    uintptr_t tid = reinterpret_cast<uintptr_t>(threadid);
+    long long numProteins = 1ll << protoLen;
+    long long offset = numProteins - 2;
+    long long segmentSize = numProteins / NUMTHREADS;
+    long long startPos = segmentSize * tid;
+    long long stopPos = (tid < (NUMTHREADS - 1)) ? segmentSize * (tid + 1) - 1 : numProteins - 1;
+
+    for (long long p = startPos; p <= stopPos; p++) {
+        long long reversed = 0;
+        for (int i = 0; i < protoLen; i++) {
+            if ((p >> i) & 1) reversed |= 1ll << (protoLen - 1 - i);
+        }
+        if (reversed < p) continue;
+
+        ContactMap hh;
+        memset(hh.bits, 0, sizeof(hh.bits));
+        int bondedHH = 0;
+        for (int i = 0; i < protoLen; i++) {
+            if (!((p >> i) & 1)) continue;
+            if (i > 0 && ((p >> (i - 1)) & 1)) bondedHH++;
+            for (int j = i + 3; j < protoLen; j += 2) {
+                if ((p >> j) & 1) {
+                    int bit = pairIndex[i][j];
+                    hh.bits[bit >> 6] |= 1ull << (bit & 63);
+                }
+            }
+        }
+
+        // The straight line is the answer until some map beats it
+        int best = 0;
+        uint32_t bestMoves = 0;
+        for (size_t c = 0; c < classes.size(); c++) {
+            // Maps are sorted biggest first, so once a map can't beat the best nothing after it can either
+            if (classes[c].contacts <= best) break;
+            const uint64_t *a = classes[c].map.bits;
+            int s = __builtin_popcountll(a[0] & hh.bits[0]) + __builtin_popcountll(a[1] & hh.bits[1]) +
+                    __builtin_popcountll(a[2] & hh.bits[2]) + __builtin_popcountll(a[3] & hh.bits[3]);
+            if (s > best) {
+                best = s;
+                bestMoves = classes[c].moves;
+            }
+        }
+
+        // Each entry only gets written by the thread that owns the canonical prototein
+        maxima[offset + p] = 2 * (best + bondedHH);
+        folds[offset + p] = bestMoves;
+        if (reversed != p) {
+            maxima[offset + reversed] = 2 * (best + bondedHH);
+            folds[offset + reversed] = reverseMoves(bestMoves);
+        }
+    }
+
+    pthread_exit(NULL);
+}
+
+void solveLength() {
+    classes.clear();
+    classOf.clear();
+    buildPairIndex();
+
+    // Enumerating every fold once
+    if (protoLen >= 3) {
+        int size = (2 * protoLen) + 1;
+        vector<int> grid(size * size, 0);
+        int center = protoLen * size + protoLen;
+        ContactMap empty;
+        memset(empty.bits, 0, sizeof(empty.bits));
+        grid[center] = 1;
+        grid[center - size] = 2;
+        enumerate(grid, size, 2, center - size, NORTH, false, empty, 0, 0);
+        sort(classes.begin(), classes.end(), compareClasses);
+    }
+
+    pthread_t threads[NUMTHREADS];
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, parallel_func, (void *)t);
+    }
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+int main(int argc, char **argv){
+    int longest = argc > 1 ? atoi(argv[1]) : DEFAULT_TABLE;
+    const char *path = argc > 2 ? argv[2] : "Prototein_Answer_Table.h";
+    if (longest < 1 || longest > MAXTABLE) {
+        cout << "Usage: " << argv[0] << " [longest length, 1 to " << MAXTABLE << "] [output file]" << endl;
+        return 1;
+    }
+
+    unsigned long long start = rdtsc();
+    // Entries for length n start at 2^n - 2
+    long long entries = (1ll << (longest + 1)) - 2;
+    maxima.assign(entries, 0);
+    folds.assign(entries, 0);
+    for (protoLen = 1; protoLen <= longest; protoLen++) solveLength();
+    unsigned long long stop = rdtsc();
+
+    ofstream out(path);
+    if (!out) {
+        cout << "Couldn't write " << path << endl;
+        return 1;
+    }
+    out << "// Made by Answer_Table_Generator, every prototein from 1 to " << longest << " long. Don't edit by hand.\n";
+    out << "#ifndef PROTOTEIN_ANSWER_TABLE_H\n#define PROTOTEIN_ANSWER_TABLE_H\n\n#include <cstdint>\n\n";
+    out << "#define ANSWER_TABLE_MAXLEN " << longest << "\n\n";
+    out << "// Entries for length n start at 2^n - 2, then go by the prototein as a binary number (H is 1, residue i is bit i)\n";
+    out << "static const unsigned char answerMaximum[" << entries << "] = {";
+    for (long long i = 0; i < entries; i++) {
+        if (i % 32 == 0) out << "\n";
+        out << (int) maxima[i] << ",";
+    }
+    out << "\n};\n\n";
+    out << "// The fold for each entry, 2 bits per move (0 forward, 1 left, 2 right), first move in the low bits\n";
+    out << "static const uint32_t answerFold[" << entries << "] = {";
+    for (long long i = 0; i < entries; i++) {
+        if (i % 16 == 0) out << "\n";
+        out << folds[i] << "u,";
+    }
+    out << "\n};\n\n#endif\n";
+    out.close();
+
+    cout << entries << " " << stop - start << endl;
+}
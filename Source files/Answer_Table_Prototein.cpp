@@ -0,0 +1,172 @@
+/*
+This is a program that calculates the Maximum number of H-H contacts for an n-length prototein by looking it up, if
+it's short enough to be in the answer table made by Answer_Table_Generator, and by searching otherwise. A lookup is an
+index and two array reads, so it's done in well under a microsecond with no threads or grid to set up.
+
+The table is built into the program: run Answer_Table_Generator first so Prototein_Answer_Table.h is next to this file,
+then compile this. Without the header this still compiles, it just searches for everything. The search is a single
+threaded depth first branch and bound with the same bound as my beam search, which for anything that would have been
+in the table is about as fast as starting threads.
+
+Like the optimized versions every walk starts by going north, and the first turn is always a left (a walk whose first
+turn is a right is the mirror image of one that turns left).
+
+Usage: Answer_Table_Prototein <prototein>
+Output: <maximum> <clock cycles>, and the fold in F/L/R notation and where the answer came from on standard error
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <string.h>
+#include <cstdint>
+#if __has_include("Prototein_Answer_Table.h")
+#include "Prototein_Answer_Table.h"
+#else
+#define ANSWER_TABLE_MAXLEN 0
+#endif
+using namespace std;
+
+#define FORWARD 0
+#define LEFT 1
+#define RIGHT 2
+
+#define WEST 0
+#define NORTH 1
+#define EAST 2
+#define SOUTH 3
+
+#define MAXLEN 32
+
+// Initializing global variables
+char *prototein;
+int protoLen;
+int gridSize;
+vector<char> grid;
+int bound[MAXLEN + 1];
+int maximum = -1;
+uint64_t maxMoves = 0;
+
+const int rowStep[4] = {0, -1, 0, 1};
+const int colStep[4] = {-1, 0, 1, 0};
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+string movesToFold(uint64_t moves) {
+    string fold = "";
+    for (int i = 0; i < protoLen - 1; i++) {
+        fold += "FLR"[(moves >> (2 * i)) & 3];
+    }
+    return fold;
+}
+
+// Looks the prototein up, false if it's not in the table
+bool lookup(int &result, uint64_t &moves) {
+#if ANSWER_TABLE_MAXLEN > 0
+    if (protoLen > ANSWER_TABLE_MAXLEN) return false;
+    long long index = (1ll << protoLen) - 2;
+    for (int i = 0; i < protoLen; i++) {
+        if (prototein[i] == 'H') index += 1ll << i;
+    }
+    result = answerMaximum[index];
+    moves = answerFold[index];
+    return true;
+#else
+    (void) result;
+    (void) moves;
+    return false;
+#endif
+}
+
+// bound[k] is the most that residues k through protoLen - 1 can add, worked out like Beam_Search_Prototein's
+void buildBound() {
+    bound[protoLen] = 0;
+    for (int j = protoLen - 1; j >= 0; j--) {
+        int most = 0;
+        if (prototein[j] == 'H' && j > 0) {
+            int otherParity = 0;
+            for (int i = (j % 2 == 0) ? 1 : 0; i < j - 1; i += 2) {
+                if (prototein[i] == 'H') otherParity++;
+            }
+            int touches = min(j == protoLen - 1 ? 3 : 2, otherParity);
+            most = 2 * (touches + (prototein[j - 1] == 'H'));
+        }
+        bound[j] = bound[j + 1] + most;
+    }
+}
+
+int contactsAt(int pos) {
+    return 2 * ((grid[pos - 1] == 'H') + (grid[pos + 1] == 'H') +
+                (grid[pos - gridSize] == 'H') + (grid[pos + gridSize] == 'H'));
+}
+
+// Places residues k through protoLen - 1
+void dfs(int k, int pos, int dir, bool turned, int score, uint64_t moves) {
+    if (k == protoLen) {
+        if (score > maximum) {
+            maximum = score;
+            maxMoves = moves;
+        }
+        return;
+    }
+    if (score + bound[k] <= maximum) return;
+
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        // Mirror images only get searched once
+        if (!turned && m == RIGHT) continue;
+
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + rowStep[d] * gridSize + colStep[d];
+        if (grid[next] != '.') continue;
+
+        grid[next] = prototein[k];
+        int gained = prototein[k] == 'H' ? contactsAt(next) : 0;
+        dfs(k + 1, next, d, turned || m != FORWARD, score + gained, moves | ((uint64_t) m << (2 * (k - 1))));
+        grid[next] = '.';
+    }
+}
+
+void search() {
+    gridSize = (2 * protoLen) + 1;
+    grid.assign(gridSize * gridSize, '.');
+    buildBound();
+    int center = protoLen * gridSize + protoLen;
+    grid[center] = prototein[0];
+    if (protoLen == 1) {
+        maximum = 0;
+        return;
+    }
+    grid[center - gridSize] = prototein[1];
+    int score = (prototein[1] == 'H') ? contactsAt(center - gridSize) : 0;
+    dfs(2, center - gridSize, NORTH, false, score, FORWARD);
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <prototein>" << endl;
+        return 1;
+    }
+    prototein = argv[1];
+    protoLen = strlen(argv[1]);
+    if (protoLen < 1 || protoLen > MAXLEN || strspn(prototein, "HP") != (size_t) protoLen) {
+        cout << "This program handles protoeins of H's and P's from 1 to " << MAXLEN << " long" << endl;
+        return 1;
+    }
+
+    unsigned long long start = rdtsc();
+    bool found = lookup(maximum, maxMoves);
+    if (!found) search();
+    unsigned long long stop = rdtsc();
+
+    cout << maximum << " " << stop - start << endl;
+    cerr << "fold: " << movesToFold(maxMoves) << (found ? " from the table" : " from a search") << endl;
+}
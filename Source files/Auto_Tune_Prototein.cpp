@@ -0,0 +1,446 @@
+/*
+This is a program that picks the fastest way to solve a prototein based on its length, so nobody has to decide by hand
+between the sequential and parallel versions. Short proteins are over before 20 threads are even started, so the
+sequential version wins there, while long ones want every core.
+
+It doesn't run the other programs, it has its own copies of their engines built in. The other programs have 20
+threads fixed when they're compiled and take nothing but the prototein, so there's no way to time them at other thread
+counts or split depths, and starting a new process for every timing would swamp the short lengths where the choice
+matters most. The copies are:
+    sequential  the same search as Optimized_Sequential_Prototein: every forward/left/right label, scored from scratch
+    labels      the same search as Optimized_Parallel_Prototein, with the number of threads as a setting
+    dfs         a depth first search that builds walks a residue at a time, split into starting walks of a set
+                number of moves that the threads pull off a shared list, with the number of threads and the length of
+                the starting walks (the split depth) as settings
+So the profile says which of these searches to use, not which program to run, and the answer is only as good as how
+closely the copies follow the programs they stand in for.
+
+"tune" times every engine and setting on this machine for each length, picks the fastest, and saves the choices as a
+list of length ranges in a tuning profile. Settings that were far behind at one length are dropped for the next, so the
+long lengths don't take forever, but only once the fastest setting takes at least a millisecond. Below that, starting
+the threads is most of the cost, and dropping the many-thread settings there would keep them out of the long lengths
+where they're supposed to win. Every later run reads the profile and uses whatever it picked for that length (or the
+closest length it has).
+
+The profile is $PROTOTEIN_TUNING, or prototein_tuning.txt in the current directory if that's not set. Each line is
+"<shortest> <longest> <engine> <threads> <split depth>".
+
+Usage: Auto_Tune_Prototein tune [longest length to tune, default 16]
+       Auto_Tune_Prototein <prototein>
+Output: <maximum> <clock cycles> when solving, the profile when tuning
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <cstdint>
+using namespace std;
+
+#define FORWARD 0
+#define LEFT 1
+#define RIGHT 2
+
+#define WEST 0
+#define NORTH 1
+#define EAST 2
+#define SOUTH 3
+
+#define SEQUENTIAL 0
+#define LABELS 1
+#define DFS 2
+
+#define MINTUNE 4
+#define DEFAULT_MAXTUNE 16
+
+// A setting is dropped once it's this many times slower than the best one at some length
+#define DROP_FACTOR 4
+
+// Nothing gets dropped at a length where the best setting takes less than this many seconds
+#define DROP_FLOOR 0.001
+
+// How many times each setting is timed, the fastest one counts
+#define REPEATS 3
+
+struct Config {
+    int engine;
+    int threads;
+    int splitDepth;
+};
+
+struct Range {
+    int shortest;
+    int longest;
+    Config config;
+};
+
+const char *engineNames[3] = {"sequential", "labels", "dfs"};
+
+// Initializing global variables. These get set before each run of an engine.
+const char *prototein;
+int protoLen;
+int numWalks;
+int numThreads;
+int splitDepth;
+vector<unsigned char> pieces;
+int numPieces;
+int nextPiece;
+int maximum;
+pthread_mutex_t mutex;
+
+const int rowStep[4] = {0, -1, 0, 1};
+const int colStep[4] = {-1, 0, 1, 0};
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+/* The label engines, same as the optimized versions */
+
+// This turns the base 10 label of the walk into base 3
+void labelToWalk(int label, int *walk) {
+    for (int i = protoLen - 2; i >= 0; i--) {
+        walk[i] = label % 3;
+        label = label / 3;
+    }
+}
+
+int score(int *walk, vector<char> &graph) {
+    int size = (2 * protoLen) + 1;
+    fill(graph.begin(), graph.end(), '.');
+
+    int row = protoLen;
+    int col = protoLen;
+    graph[row * size + col] = prototein[0];
+
+    int dir = NORTH;
+    for (int i = 1; i < protoLen; i++) {
+        if (walk[i - 1] == LEFT) dir = (dir + 3) % 4;
+        if (walk[i - 1] == RIGHT) dir = (dir + 1) % 4;
+        row += rowStep[dir];
+        col += colStep[dir];
+        if (graph[row * size + col] != '.') return -1;
+        graph[row * size + col] = prototein[i];
+    }
+
+    int score = 0;
+    for (int i = 1; i < size - 1; i++) {
+        for (int j = 1; j < size - 1; j++) {
+            if (graph[i * size + j] != 'H') continue;
+            if (graph[(i + 1) * size + j] == 'H') score++;
+            if (graph[i * size + j + 1] == 'H') score++;
+            if (graph[(i - 1) * size + j] == 'H') score++;
+            if (graph[i * size + j - 1] == 'H') score++;
+        }
+    }
+    return score;
+}
+
+void *label_func(void *threadid) {
+    uintptr_t tid = reinterpret_cast<uintptr_t>(threadid);
+    int segmentSize = numWalks / numThreads;
+    int startPos = segmentSize * tid;
+    int stopPos = ((int) tid < numThreads - 1) ? segmentSize * (tid + 1) - 1 : numWalks - 1;
+    int localMaximum = -1;
+
+    vector<int> walk(protoLen);
+    vector<char> graph(((2 * protoLen) + 1) * ((2 * protoLen) + 1));
+    for (int i = startPos; i <= stopPos; i++) {
+        labelToWalk(i, walk.data());
+        int s = score(walk.data(), graph);
+        if (s > localMaximum) localMaximum = s;
+    }
+
+    pthread_mutex_lock(&mutex);
+    if (localMaximum > maximum) maximum = localMaximum;
+    pthread_mutex_unlock(&mutex);
+    return NULL;
+}
+
+/* The depth first engine */
+
+struct Search {
+    vector<char> grid;
+    int size;
+    int best;
+};
+
+int contactsAt(Search &s, int pos) {
+    return 2 * ((s.grid[pos - 1] == 'H') + (s.grid[pos + 1] == 'H') +
+                (s.grid[pos - s.size] == 'H') + (s.grid[pos + s.size] == 'H'));
+}
+
+void dfs(Search &s, int k, int pos, int dir, bool turned, int score) {
+    if (k == protoLen) {
+        if (score > s.best) s.best = score;
+        return;
+    }
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        if (!turned && m == RIGHT) continue;
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + rowStep[d] * s.size + colStep[d];
+        if (s.grid[next] != '.') continue;
+        s.grid[next] = prototein[k];
+        dfs(s, k + 1, next, d, turned || m != FORWARD, score + (prototein[k] == 'H' ? contactsAt(s, next) : 0));
+        s.grid[next] = '.';
+    }
+}
+
+void collectPieces(vector<char> &grid, int size, int pos, int dir, bool turned, vector<unsigned char> &current) {
+    if ((int) current.size() == splitDepth) {
+        pieces.insert(pieces.end(), current.begin(), current.end());
+        numPieces++;
+        return;
+    }
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        if (!turned && m == RIGHT) continue;
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + rowStep[d] * size + colStep[d];
+        if (grid[next] != '.') continue;
+        grid[next] = 'X';
+        current.push_back(m);
+        collectPieces(grid, size, next, d, turned || m != FORWARD, current);
+        current.pop_back();
+        grid[next] = '.';
+    }
+}
+
+void *dfs_func(void *) {
+    Search s;
+    s.size = (2 * protoLen) + 1;
+    s.grid.assign(s.size * s.size, '.');
+    s.best = -1;
+    int center = protoLen * s.size + protoLen;
+    vector<int> cells(protoLen);
+
+    while (true) {
+        pthread_mutex_lock(&mutex);
+        int piece = nextPiece++;
+        pthread_mutex_unlock(&mutex);
+        if (piece >= numPieces) break;
+
+        int pos = center;
+        int dir = NORTH;
+        bool turned = false;
+        s.grid[pos] = prototein[0];
+        cells[0] = pos;
+        pos -= s.size;
+        s.grid[pos] = prototein[1];
+        cells[1] = pos;
+        int score = prototein[1] == 'H' ? contactsAt(s, pos) : 0;
+        const unsigned char *moves = pieces.data() + (size_t) piece * splitDepth;
+        for (int i = 0; i < splitDepth; i++) {
+            if (moves[i] == LEFT) dir = (dir + 3) % 4;
+            if (moves[i] == RIGHT) dir = (dir + 1) % 4;
+            turned = turned || moves[i] != FORWARD;
+            pos += rowStep[dir] * s.size + colStep[dir];
+            s.grid[pos] = prototein[i + 2];
+            cells[i + 2] = pos;
+            if (prototein[i + 2] == 'H') score += contactsAt(s, pos);
+        }
+        dfs(s, splitDepth + 2, pos, dir, turned, score);
+        for (int i = 0; i < splitDepth + 2; i++) s.grid[cells[i]] = '.';
+    }
+
+    pthread_mutex_lock(&mutex);
+    if (s.best > maximum) maximum = s.best;
+    pthread_mutex_unlock(&mutex);
+    return NULL;
+}
+
+// Solves the prototein with the given engine and settings
+int solve(const char *p, const Config &config) {
+    prototein = p;
+    protoLen = strlen(p);
+    maximum = -1;
+    numThreads = config.threads;
+
+    if (protoLen < 3) {
+        // Nothing to choose from, there's only one fold
+        return (protoLen == 2 && p[0] == 'H' && p[1] == 'H') ? 2 : 0;
+    }
+
+    vector<pthread_t> threads(numThreads);
+    if (config.engine == SEQUENTIAL || config.engine == LABELS) {
+        numWalks = 1;
+        for (int i = 0; i < protoLen - 2; i++) numWalks *= 3;
+        if (config.engine == SEQUENTIAL) {
+            numThreads = 1;
+            label_func((void *) 0);
+            return maximum;
+        }
+        for (long t = 0; t < numThreads; t++) pthread_create(&threads[t], NULL, label_func, (void *)t);
+    } else {
+        splitDepth = min(config.splitDepth, protoLen - 2);
+        int size = (2 * protoLen) + 1;
+        vector<char> grid(size * size, '.');
+        int center = protoLen * size + protoLen;
+        grid[center] = 'X';
+        grid[center - size] = 'X';
+        pieces.clear();
+        numPieces = 0;
+        nextPiece = 0;
+        vector<unsigned char> current;
+        collectPieces(grid, size, center - size, NORTH, false, current);
+        for (long t = 0; t < numThreads; t++) pthread_create(&threads[t], NULL, dfs_func, NULL);
+    }
+    for (int t = 0; t < numThreads; t++) pthread_join(threads[t], NULL);
+    return maximum;
+}
+
+const char *profilePath() {
+    const char *path = getenv("PROTOTEIN_TUNING");
+    return path != NULL ? path : "prototein_tuning.txt";
+}
+
+// Every setting worth trying on this machine
+vector<Config> allConfigs() {
+    vector<Config> configs;
+    Config c;
+    c.engine = SEQUENTIAL;
+    c.threads = 1;
+    c.splitDepth = 0;
+    configs.push_back(c);
+
+    // Powers of two up to twice the number of cores, plus the 20 the parallel versions use
+    int cores = max(1, (int) sysconf(_SC_NPROCESSORS_ONLN));
+    vector<int> threadCounts;
+    for (int t = 2; t <= 2 * cores; t *= 2) threadCounts.push_back(t);
+    if (find(threadCounts.begin(), threadCounts.end(), 20) == threadCounts.end()) threadCounts.push_back(20);
+
+    for (size_t i = 0; i < threadCounts.size(); i++) {
+        c.engine = LABELS;
+        c.threads = threadCounts[i];
+        c.splitDepth = 0;
+        configs.push_back(c);
+    }
+    threadCounts.insert(threadCounts.begin(), 1);
+    for (size_t i = 0; i < threadCounts.size(); i++) {
+        for (int depth = 1; depth <= 8; depth++) {
+            c.engine = DFS;
+            c.threads = threadCounts[i];
+            c.splitDepth = depth;
+            configs.push_back(c);
+        }
+    }
+    return configs;
+}
+
+void tune(int longest) {
+    vector<Config> configs = allConfigs();
+    vector<bool> alive(configs.size(), true);
+    vector<Range> ranges;
+
+    // The same made up prototein every time, the search cost barely depends on the H/P pattern
+    srand(12345);
+    for (int n = MINTUNE; n <= longest; n++) {
+        string p = "";
+        for (int i = 0; i < n; i++) p += (rand() % 2) ? 'H' : 'P';
+
+        vector<double> times(configs.size(), 1e300);
+        double best = 1e300;
+        int bestConfig = -1;
+        for (size_t c = 0; c < configs.size(); c++) {
+            if (!alive[c]) continue;
+            // Split depths past the end of the prototein are the same as the deepest one
+            if (configs[c].engine == DFS && configs[c].splitDepth > n - 2) continue;
+            for (int r = 0; r < REPEATS; r++) {
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                solve(p.c_str(), configs[c]);
+                double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                times[c] = min(times[c], seconds);
+            }
+            if (times[c] < best) {
+                best = times[c];
+                bestConfig = c;
+            }
+        }
+        for (size_t c = 0; c < configs.size() && best >= DROP_FLOOR; c++) {
+            if (times[c] < 1e300 && times[c] > DROP_FACTOR * best) alive[c] = false;
+        }
+
+        Config pick = configs[bestConfig];
+        cout << n << ": " << engineNames[pick.engine] << " threads " << pick.threads << " split depth "
+             << pick.splitDepth << " (" << best * 1e6 << " us)" << endl;
+        if (!ranges.empty() && ranges.back().config.engine == pick.engine &&
+            ranges.back().config.threads == pick.threads && ranges.back().config.splitDepth == pick.splitDepth) {
+            ranges.back().longest = n;
+        } else {
+            Range range;
+            range.shortest = n;
+            range.longest = n;
+            range.config = pick;
+            ranges.push_back(range);
+        }
+    }
+
+    ofstream out(profilePath());
+    for (size_t i = 0; i < ranges.size(); i++) {
+        out << ranges[i].shortest << " " << ranges[i].longest << " " << engineNames[ranges[i].config.engine] << " "
+            << ranges[i].config.threads << " " << ranges[i].config.splitDepth << endl;
+    }
+    cout << "Saved to " << profilePath() << endl;
+}
+
+// Looks up the setting for a length in the profile. Lengths outside every range use the closest one.
+// Without a profile it falls back to the optimized parallel version's 20 threads.
+Config pickConfig(int n) {
+    Config pick;
+    pick.engine = LABELS;
+    pick.threads = 20;
+    pick.splitDepth = 0;
+
+    ifstream in(profilePath());
+    int shortest, longest, threads, depth;
+    string name;
+    int closest = -1;
+    while (in >> shortest >> longest >> name >> threads >> depth) {
+        int distance = (n < shortest) ? shortest - n : (n > longest ? n - longest : 0);
+        if (closest != -1 && distance >= closest) continue;
+        for (int e = 0; e < 3; e++) {
+            if (name == engineNames[e]) {
+                pick.engine = e;
+                pick.threads = max(1, threads);
+                pick.splitDepth = depth;
+                closest = distance;
+            }
+        }
+    }
+    return pick;
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " tune [longest length]" << endl;
+        cout << "       " << argv[0] << " <prototein>" << endl;
+        return 1;
+    }
+    pthread_mutex_init(&mutex, 0);
+
+    if (strcmp(argv[1], "tune") == 0) {
+        int longest = argc > 2 ? atoi(argv[2]) : DEFAULT_MAXTUNE;
+        tune(max(MINTUNE, longest));
+    } else {
+        unsigned long long start = rdtsc();
+        Config config = pickConfig(strlen(argv[1]));
+        int result = solve(argv[1], config);
+        unsigned long long stop = rdtsc();
+        cout << result << " " << stop - start << endl;
+    }
+
+    pthread_mutex_destroy(&mutex);
+}
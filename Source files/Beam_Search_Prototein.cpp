@@ -0,0 +1,401 @@
+/*
+This is a program that calculates the Maximum number of H-H contacts for an n-length prototein in two stages. The
+first stage is a quick beam search that gets a good (but not guaranteed best) fold in a few milliseconds. The second
+stage is an exact depth first search that starts out already knowing that score, so it can skip any partial walk that
+can't beat it, instead of starting at -1 and having to stumble onto a good fold before it can skip anything.
+
+Both stages need an upper bound on how much the residues that haven't been placed yet can still add. When residue j
+gets placed it touches the residue before it, plus at most 2 others (3 if it's the last residue, since nothing has to
+come after it). On the square lattice two residues can only touch if one is at an even position and the other at an
+odd one, so it can't touch more earlier H's than there are of the other parity. Each H-H neighbour is worth 2, the same
+as in the other programs. Adding that up from j to the end gives the bound for every depth, worked out once.
+
+The beam search grows folds one residue at a time and keeps only the best B partial folds at each length, ranked by
+their score so far plus the bound for the rest. The expansion of each level is split across the threads. Its best fold
+becomes the starting answer for the exact search, which splits the work into short starting walks like my pruned
+version and shares the best score found so far between threads.
+
+Like the optimized versions every walk starts by going north, and the first turn is always a left (a walk whose first
+turn is a right is the mirror image of one that turns left).
+
+If every fold in the beam traps itself before the end, the beam is doubled and run again (with a note on standard
+error), so there is always a beam answer. Passing "approx" skips the exact stage and just prints the beam search
+answer. Standard output gets the maximum and the run time like the other programs, standard error gets the fold (in
+F/L/R notation), the beam score, and node counts.
+
+Usage: Beam_Search_Prototein <prototein> [beam width] [approx]
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <cstdint>
+using namespace std;
+
+#define FORWARD 0
+#define LEFT 1
+#define RIGHT 2
+
+#define WEST 0
+#define NORTH 1
+#define EAST 2
+#define SOUTH 3
+
+#define NUMTHREADS 20
+#define MAXLEN 31
+#define BEAMWIDTH 1000
+
+// Roughly how many starting walks each thread gets in the exact stage
+#define PIECES_PER_THREAD 16
+
+// A partial fold in the beam. Moves are packed 2 bits each, move i places residue i + 1.
+struct Partial {
+    uint64_t moves;
+    int score;
+    int rank;
+};
+
+// Initializing global variables
+char *prototein;
+int protoLen;
+int gridSize;
+int beamWidth = BEAMWIDTH;
+int bound[MAXLEN + 1];
+vector<Partial> beam;
+vector<Partial> candidates[NUMTHREADS];
+pthread_barrier_t barrier;
+
+int maximum = -1;
+uint64_t maxMoves = 0;
+int splitDepth;
+vector<unsigned char> pieces;
+int numPieces;
+int nextPiece = 0;
+long long totalNodes = 0;
+pthread_mutex_t mutex;
+
+const int rowStep[4] = {0, -1, 0, 1};
+const int colStep[4] = {-1, 0, 1, 0};
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+// bound[k] is the most that residues k through protoLen - 1 can add, see the top of the file
+void buildBound() {
+    bound[protoLen] = 0;
+    for (int j = protoLen - 1; j >= 0; j--) {
+        int most = 0;
+        if (prototein[j] == 'H' && j > 0) {
+            int otherParity = 0;
+            for (int i = (j % 2 == 0) ? 1 : 0; i < j - 1; i += 2) {
+                if (prototein[i] == 'H') otherParity++;
+            }
+            int touches = min(j == protoLen - 1 ? 3 : 2, otherParity);
+            most = 2 * (touches + (prototein[j - 1] == 'H'));
+        }
+        bound[j] = bound[j + 1] + most;
+    }
+}
+
+string movesToFold(uint64_t moves) {
+    string fold = "";
+    for (int i = 0; i < protoLen - 1; i++) {
+        fold += "FLR"[(moves >> (2 * i)) & 3];
+    }
+    return fold;
+}
+
+int contactsAt(const vector<char> &grid, int pos) {
+    return 2 * ((grid[pos - 1] == 'H') + (grid[pos + 1] == 'H') +
+                (grid[pos - gridSize] == 'H') + (grid[pos + gridSize] == 'H'));
+}
+
+bool betterPartial(const Partial &a, const Partial &b) {
+    if (a.rank != b.rank) return a.rank > b.rank;
+    return a.score > b.score;
+}
+
+// Beam search worker. At each length every thread extends its share of the beam by one residue, then thread 0
+// keeps the best beamWidth of all the new partial folds.
+void *beam_func(void *threadid) {
+    uintptr_t tid = reinterpret_cast<uintptr_t>(threadid);
+    vector<char> grid(gridSize * gridSize, '.');
+    vector<int> cells(protoLen);
+    int center = protoLen * gridSize + protoLen;
+
+    for (int k = 2; k < protoLen; k++) {
+        candidates[tid].clear();
+        for (size_t b = tid; b < beam.size(); b += NUMTHREADS) {
+            const Partial &p = beam[b];
+
+            // Laying the partial fold back down on this thread's grid
+            int pos = center;
+            int dir = NORTH;
+            bool turned = false;
+            grid[pos] = prototein[0];
+            cells[0] = pos;
+            for (int i = 1; i < k; i++) {
+                int m = (p.moves >> (2 * (i - 1))) & 3;
+                if (m == LEFT) dir = (dir + 3) % 4;
+                if (m == RIGHT) dir = (dir + 1) % 4;
+                turned = turned || m != FORWARD;
+                pos += rowStep[dir] * gridSize + colStep[dir];
+                grid[pos] = prototein[i];
+                cells[i] = pos;
+            }
+
+            for (int m = FORWARD; m <= RIGHT; m++) {
+                if (!turned && m == RIGHT) continue;
+                int d = dir;
+                if (m == LEFT) d = (dir + 3) % 4;
+                if (m == RIGHT) d = (dir + 1) % 4;
+                int next = pos + rowStep[d] * gridSize + colStep[d];
+                if (grid[next] != '.') continue;
+
+                Partial child;
+                child.moves = p.moves | ((uint64_t) m << (2 * (k - 1)));
+                child.score = p.score + (prototein[k] == 'H' ? contactsAt(grid, next) : 0);
+                child.rank = child.score + bound[k + 1];
+                candidates[tid].push_back(child);
+            }
+
+            for (int i = 0; i < k; i++) grid[cells[i]] = '.';
+        }
+
+        pthread_barrier_wait(&barrier);
+        if (tid == 0) {
+            beam.clear();
+            for (int t = 0; t < NUMTHREADS; t++) {
+                beam.insert(beam.end(), candidates[t].begin(), candidates[t].end());
+            }
+            if ((int) beam.size() > beamWidth) {
+                nth_element(beam.begin(), beam.begin() + beamWidth, beam.end(), betterPartial);
+                beam.resize(beamWidth);
+            }
+        }
+        pthread_barrier_wait(&barrier);
+    }
+
+    pthread_exit(NULL);
+}
+
+// Runs the beam search and makes its best fold the current answer. A narrow beam can fill up with folds that all box
+// themselves in and leave nothing to finish, so when that happens the beam is doubled and the search starts over.
+void beamSearch() {
+    while (true) {
+        Partial first;
+        first.moves = FORWARD;
+        first.score = (prototein[0] == 'H' && prototein[1] == 'H') ? 2 : 0;
+        first.rank = first.score + bound[2];
+        beam.assign(1, first);
+
+        pthread_t threads[NUMTHREADS];
+        pthread_barrier_init(&barrier, NULL, NUMTHREADS);
+        for (long t = 0; t < NUMTHREADS; t++) {
+            pthread_create(&threads[t], NULL, beam_func, (void *)t);
+        }
+        for (long t = 0; t < NUMTHREADS; t++) {
+            pthread_join(threads[t], NULL);
+        }
+        pthread_barrier_destroy(&barrier);
+
+        if (!beam.empty()) break;
+        cerr << "beam of width " << beamWidth << " died out, trying " << 2 * beamWidth << endl;
+        beamWidth *= 2;
+    }
+
+    for (size_t b = 0; b < beam.size(); b++) {
+        if (beam[b].score > maximum) {
+            maximum = beam[b].score;
+            maxMoves = beam[b].moves;
+        }
+    }
+}
+
+struct Search {
+    vector<char> grid;
+    uint64_t moves;
+    int best;
+    uint64_t bestMoves;
+    long long nodes;
+};
+
+// Exact search of residues k through protoLen - 1, skipping anything that can't beat the best score so far
+void dfs(Search &s, int k, int pos, int dir, bool turned, int score) {
+    if (k == protoLen) {
+        if (score > s.best) {
+            s.best = score;
+            s.bestMoves = s.moves;
+            pthread_mutex_lock(&mutex);
+            if (score > maximum) {
+                __atomic_store_n(&maximum, score, __ATOMIC_RELAXED);
+                maxMoves = s.moves;
+            }
+            pthread_mutex_unlock(&mutex);
+        }
+        return;
+    }
+    s.nodes++;
+
+    // Another thread may have found something better, reading it without the lock is fine since it only goes up
+    int best = max(s.best, __atomic_load_n(&maximum, __ATOMIC_RELAXED));
+    if (score + bound[k] <= best) return;
+
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        if (!turned && m == RIGHT) continue;
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + rowStep[d] * gridSize + colStep[d];
+        if (s.grid[next] != '.') continue;
+
+        s.grid[next] = prototein[k];
+        uint64_t saved = s.moves;
+        s.moves |= (uint64_t) m << (2 * (k - 1));
+        int gained = prototein[k] == 'H' ? contactsAt(s.grid, next) : 0;
+        dfs(s, k + 1, next, d, turned || m != FORWARD, score + gained);
+        s.moves = saved;
+        s.grid[next] = '.';
+    }
+}
+
+void collectPieces(vector<char> &grid, int depth, int pos, int dir, bool turned, vector<unsigned char> &current) {
+    if ((int) current.size() == depth) {
+        pieces.insert(pieces.end(), current.begin(), current.end());
+        numPieces++;
+        return;
+    }
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        if (!turned && m == RIGHT) continue;
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + rowStep[d] * gridSize + colStep[d];
+        if (grid[next] != '.') continue;
+        grid[next] = 'X';
+        current.push_back(m);
+        collectPieces(grid, depth, next, d, turned || m != FORWARD, current);
+        current.pop_back();
+        grid[next] = '.';
+    }
+}
+
+void *exact_func(void *){
+    Search s;
+    s.grid.assign(gridSize * gridSize, '.');
+    s.best = -1;
+    s.bestMoves = 0;
+    s.nodes = 0;
+    int center = protoLen * gridSize + protoLen;
+    vector<int> cells(protoLen);
+
+    while (true) {
+        pthread_mutex_lock(&mutex);
+        int piece = nextPiece++;
+        pthread_mutex_unlock(&mutex);
+        if (piece >= numPieces) break;
+
+        // Replaying the starting walk: residue 0 in the middle, residue 1 north of it, then the piece's moves
+        int pos = center;
+        int dir = NORTH;
+        bool turned = false;
+        s.grid[pos] = prototein[0];
+        cells[0] = pos;
+        pos -= gridSize;
+        s.grid[pos] = prototein[1];
+        cells[1] = pos;
+        int score = (prototein[1] == 'H') ? contactsAt(s.grid, pos) : 0;
+        s.moves = FORWARD;
+        const unsigned char *moves = pieces.data() + (size_t) piece * splitDepth;
+        for (int i = 0; i < splitDepth; i++) {
+            if (moves[i] == LEFT) dir = (dir + 3) % 4;
+            if (moves[i] == RIGHT) dir = (dir + 1) % 4;
+            turned = turned || moves[i] != FORWARD;
+            pos += rowStep[dir] * gridSize + colStep[dir];
+            s.grid[pos] = prototein[i + 2];
+            cells[i + 2] = pos;
+            s.moves |= (uint64_t) moves[i] << (2 * (i + 1));
+            if (prototein[i + 2] == 'H') score += contactsAt(s.grid, pos);
+        }
+
+        dfs(s, splitDepth + 2, pos, dir, turned, score);
+
+        for (int i = 0; i < splitDepth + 2; i++) s.grid[cells[i]] = '.';
+    }
+
+    pthread_mutex_lock(&mutex);
+    totalNodes += s.nodes;
+    pthread_mutex_unlock(&mutex);
+
+    pthread_exit(NULL);
+}
+
+// Runs the exact search, starting from whatever the beam search found
+void exactSearch() {
+    vector<char> grid(gridSize * gridSize, '.');
+    int center = protoLen * gridSize + protoLen;
+    grid[center] = 'X';
+    grid[center - gridSize] = 'X';
+    splitDepth = 0;
+    numPieces = 1;
+    while (splitDepth < protoLen - 2 && numPieces < NUMTHREADS * PIECES_PER_THREAD) {
+        splitDepth++;
+        pieces.clear();
+        numPieces = 0;
+        vector<unsigned char> current;
+        collectPieces(grid, splitDepth, center - gridSize, NORTH, false, current);
+    }
+
+    pthread_t threads[NUMTHREADS];
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, exact_func, NULL);
+    }
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <prototein> [beam width] [approx]" << endl;
+        return 1;
+    }
+    prototein = argv[1];
+    protoLen = strlen(argv[1]);
+    if (protoLen < 2 || protoLen > MAXLEN) {
+        cout << "This program handles protoeins from 2 to " << MAXLEN << " long" << endl;
+        return 1;
+    }
+    bool approximate = false;
+    for (int a = 2; a < argc; a++) {
+        if (strcmp(argv[a], "approx") == 0) approximate = true;
+        else beamWidth = max(1, atoi(argv[a]));
+    }
+
+    gridSize = (2 * protoLen) + 1;
+    buildBound();
+    pthread_mutex_init(&mutex, 0);
+
+    unsigned long long start = rdtsc();
+    beamSearch();
+    unsigned long long beamStop = rdtsc();
+    int beamScore = maximum;
+
+    if (!approximate) exactSearch();
+    unsigned long long stop = rdtsc();
+
+    cout << maximum << " " << stop - start << endl;
+    cerr << "fold: " << movesToFold(maxMoves) << " beam: " << beamScore << " (" << beamStop - start
+         << " cycles) exact nodes: " << totalNodes << endl;
+
+    pthread_mutex_destroy(&mutex);
+}
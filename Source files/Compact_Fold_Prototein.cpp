@@ -0,0 +1,364 @@
+/*
+This is a program that calculates the Maximum number of H-H contacts for proteins that fill a rows x cols box exactly
+(for example 36 residues filling a 6x6 square), counting only the fully compact folds: the ones that fit in the box.
+Those folds are Hamiltonian paths of the box (walks through every cell once), and there are far fewer of them than
+self avoiding walks, so this gets exact compact answers for 36 to 49 residues where the other programs can't finish.
+
+The paths are enumerated once and every prototein given is scored against each one, so scoring a whole list costs
+about the same as scoring one. A path is stored as a contact mask per residue (the higher numbered residues next to it
+in the box, not counting the one it's bonded to), which makes scoring a prototein a popcount per H.
+
+The box's own symmetries are used so that only one path out of every set of rotations and reflections is walked (4 of
+them for a rectangle, 8 for a square). A path is only kept if its list of cells comes first alphabetically among all
+of its copies. That's checked as the path grows: the starting cell has to be the smallest of its copies, and for the
+symmetries that leave the starting cell where it is, the path gets cut as soon as one of them would make a smaller
+next cell. No path is its own copy, so every path stands for exactly the same number of paths.
+
+Two cheap checks cut off paths that can't fill the box:
+    parity   the box is a checkerboard and the path alternates colours, so if the box has an odd number of cells the
+             path has to start on the colour there's more of
+    dead end once the path moves on, a free cell it just went past that has no free neighbours can never be reached,
+             and one with a single free neighbour has to be where the path ends. Two of those and the path is cut.
+
+The paths are split into short starting paths that the 20 threads take turns pulling off a shared list.
+
+Usage: Compact_Fold_Prototein <rows> <cols> [prototein ...]
+Proteins have to be rows x cols long. If none are given on the command line they're read from standard input.
+Output: one "<prototein> <maximum> <fold>" line per prototein (fold in F/L/R notation), then
+"<paths up to symmetry> <clock cycles>"
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <cstdint>
+using namespace std;
+
+#define NUMTHREADS 20
+#define MAXCELLS 64
+#define MAXSYMMETRIES 8
+
+// Roughly how many starting paths each thread gets
+#define PIECES_PER_THREAD 16
+
+// Initializing global variables
+int rows;
+int cols;
+int numCells;
+uint64_t allCells;
+uint64_t neighbours[MAXCELLS];
+int numSymmetries;
+int symmetry[MAXSYMMETRIES][MAXCELLS];
+vector<string> proteins;
+vector<uint64_t> hydrophobic;
+vector<int> bondedPairs;
+int splitDepth;
+vector<unsigned char> pieces;
+int numPieces;
+int nextPiece = 0;
+vector<int> maximum;
+vector<vector<unsigned char> > maxPaths;
+long long totalPaths = 0;
+pthread_mutex_t mutex;
+
+// Where a path has got to: cells not on it yet, cells that have to be its end, its last cell, how many cells it has,
+// and the symmetries (by bit) it's still tied with
+struct State {
+    uint64_t free;
+    uint64_t ends;
+    int head;
+    int length;
+    unsigned tied;
+};
+
+// Everything one thread needs
+struct Search {
+    unsigned char path[MAXCELLS];
+    int residueAt[MAXCELLS];
+    uint64_t contacts[MAXCELLS];
+    vector<int> best;
+    vector<vector<unsigned char> > bestPaths;
+    long long paths;
+};
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+// Neighbour masks and the box's symmetries as cell to cell maps
+void buildBox() {
+    numCells = rows * cols;
+    allCells = numCells == 64 ? ~0ull : (1ull << numCells) - 1;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            uint64_t mask = 0;
+            if (r > 0) mask |= 1ull << ((r - 1) * cols + c);
+            if (r < rows - 1) mask |= 1ull << ((r + 1) * cols + c);
+            if (c > 0) mask |= 1ull << (r * cols + c - 1);
+            if (c < cols - 1) mask |= 1ull << (r * cols + c + 1);
+            neighbours[r * cols + c] = mask;
+        }
+    }
+
+    numSymmetries = (rows == cols) ? 8 : 4;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int cell = r * cols + c;
+            int R = rows - 1 - r;
+            int C = cols - 1 - c;
+            symmetry[0][cell] = cell;
+            symmetry[1][cell] = R * cols + C;
+            symmetry[2][cell] = R * cols + c;
+            symmetry[3][cell] = r * cols + C;
+            if (rows == cols) {
+                symmetry[4][cell] = c * cols + r;
+                symmetry[5][cell] = C * cols + R;
+                symmetry[6][cell] = c * cols + R;
+                symmetry[7][cell] = C * cols + r;
+            }
+        }
+    }
+}
+
+// Can a path start here? It has to be the smallest of its copies and, in an odd box, on the majority colour.
+bool canStart(int cell, unsigned &tied) {
+    if (numCells % 2 == 1 && (cell / cols + cell % cols) % 2 != 0) return false;
+    tied = 0;
+    for (int g = 1; g < numSymmetries; g++) {
+        if (symmetry[g][cell] < cell) return false;
+        if (symmetry[g][cell] == cell) tied |= 1u << g;
+    }
+    return true;
+}
+
+// Moves the path on to cell, false if it can't be the first of its copies or can't fill the box from here
+inline bool advance(State &s, unsigned char *path, int cell) {
+    for (unsigned t = s.tied; t != 0; t &= t - 1) {
+        int g = __builtin_ctz(t);
+        int copy = symmetry[g][cell];
+        if (copy < cell) return false;
+        if (copy > cell) s.tied &= ~(1u << g);
+    }
+
+    s.free &= ~(1ull << cell);
+    // The cells next to the old head that the path didn't take
+    for (uint64_t m = neighbours[s.head] & s.free; m != 0; m &= m - 1) {
+        int x = __builtin_ctzll(m);
+        int exits = __builtin_popcountll(neighbours[x] & s.free);
+        if (exits == 0) return false;
+        if (exits == 1) s.ends |= 1ull << x;
+    }
+    if (__builtin_popcountll(s.ends & s.free) > 1) return false;
+
+    s.head = cell;
+    path[s.length++] = cell;
+    return true;
+}
+
+// A full path: scoring every prototein against it
+void scorePath(Search &s) {
+    s.paths++;
+    for (int i = 0; i < numCells; i++) s.residueAt[s.path[i]] = i;
+    for (int i = 0; i < numCells; i++) {
+        uint64_t mask = 0;
+        for (uint64_t m = neighbours[s.path[i]]; m != 0; m &= m - 1) {
+            int j = s.residueAt[__builtin_ctzll(m)];
+            if (j > i + 1) mask |= 1ull << j;
+        }
+        s.contacts[i] = mask;
+    }
+
+    for (size_t p = 0; p < proteins.size(); p++) {
+        uint64_t h = hydrophobic[p];
+        int pairs = bondedPairs[p];
+        for (uint64_t m = h; m != 0; m &= m - 1) {
+            pairs += __builtin_popcountll(s.contacts[__builtin_ctzll(m)] & h);
+        }
+        // Every H-H neighbour counts twice, like the other programs
+        if (2 * pairs > s.best[p]) {
+            s.best[p] = 2 * pairs;
+            s.bestPaths[p].assign(s.path, s.path + numCells);
+        }
+    }
+}
+
+void dfs(Search &search, const State &s) {
+    if (s.free == 0) {
+        scorePath(search);
+        return;
+    }
+    for (uint64_t m = neighbours[s.head] & s.free; m != 0; m &= m - 1) {
+        State next = s;
+        if (advance(next, search.path, __builtin_ctzll(m))) dfs(search, next);
+    }
+}
+
+void collectPieces(Search &search, const State &s) {
+    if (s.length == splitDepth || s.free == 0) {
+        if (s.length < splitDepth) return;
+        pieces.insert(pieces.end(), search.path, search.path + splitDepth);
+        numPieces++;
+        return;
+    }
+    for (uint64_t m = neighbours[s.head] & s.free; m != 0; m &= m - 1) {
+        State next = s;
+        if (advance(next, search.path, __builtin_ctzll(m))) collectPieces(search, next);
+    }
+}
+
+// A path that's just its starting cell
+State startAt(Search &search, int cell, unsigned tied) {
+    State s;
+    s.free = allCells & ~(1ull << cell);
+    s.ends = 0;
+    s.head = cell;
+    s.length = 1;
+    s.tied = tied;
+    search.path[0] = cell;
+    return s;
+}
+
+void *parallel_func(void *){
+    Search search;
+    search.best.assign(proteins.size(), -1);
+    search.bestPaths.assign(proteins.size(), vector<unsigned char>());
+    search.paths = 0;
+
+    while (true) {
+        pthread_mutex_lock(&mutex);
+        int piece = nextPiece++;
+        pthread_mutex_unlock(&mutex);
+        if (piece >= numPieces) break;
+
+        // Replaying the starting path, which already passed every check when it was collected
+        const unsigned char *cells = pieces.data() + (size_t) piece * splitDepth;
+        unsigned tied;
+        canStart(cells[0], tied);
+        State s = startAt(search, cells[0], tied);
+        for (int i = 1; i < splitDepth; i++) advance(s, search.path, cells[i]);
+
+        dfs(search, s);
+    }
+
+    // These mutex's are required for this function to be thread safe. Should not really impact performance because its only called 20 times.
+    pthread_mutex_lock(&mutex);
+    totalPaths += search.paths;
+    for (size_t p = 0; p < proteins.size(); p++) {
+        if (search.best[p] > maximum[p]) {
+            maximum[p] = search.best[p];
+            maxPaths[p] = search.bestPaths[p];
+        }
+    }
+    pthread_mutex_unlock(&mutex);
+
+    pthread_exit(NULL);
+}
+
+// The path in F/L/R notation, flipped if need be so its first turn is a left like the other programs
+string pathToFold(const vector<unsigned char> &path) {
+    string fold = "F";
+    bool flip = false;
+    bool turned = false;
+    for (int i = 2; i < (int) path.size(); i++) {
+        int r1 = path[i - 1] / cols - path[i - 2] / cols;
+        int c1 = path[i - 1] % cols - path[i - 2] % cols;
+        int r2 = path[i] / cols - path[i - 1] / cols;
+        int c2 = path[i] % cols - path[i - 1] % cols;
+        // Rows go down, so turning from north to west (a left) gives a negative cross product
+        int cross = c1 * r2 - r1 * c2;
+        char m = 'F';
+        if (cross < 0) m = 'L';
+        if (cross > 0) m = 'R';
+        if (!turned && m != 'F') {
+            turned = true;
+            flip = (m == 'R');
+        }
+        if (flip && m == 'L') m = 'R';
+        else if (flip && m == 'R') m = 'L';
+        fold += m;
+    }
+    return fold.substr(0, max(0, numCells - 1));
+}
+
+int main(int argc, char **argv){
+    if (argc < 3) {
+        cout << "Usage: " << argv[0] << " <rows> <cols> [prototein ...]" << endl;
+        return 1;
+    }
+    rows = atoi(argv[1]);
+    cols = atoi(argv[2]);
+    if (rows < 1 || cols < 1 || rows * cols > MAXCELLS) {
+        cout << "The box has to have between 1 and " << MAXCELLS << " cells" << endl;
+        return 1;
+    }
+    buildBox();
+
+    if (argc > 3) {
+        for (int i = 3; i < argc; i++) proteins.push_back(argv[i]);
+    } else {
+        string line;
+        while (cin >> line) proteins.push_back(line);
+    }
+    for (size_t p = 0; p < proteins.size(); p++) {
+        const string &q = proteins[p];
+        if ((int) q.size() != numCells || q.find_first_not_of("HP") != string::npos) {
+            cout << q << " has to be " << numCells << " H's and P's long to fill the box" << endl;
+            return 1;
+        }
+        uint64_t h = 0;
+        int bonded = 0;
+        for (int i = 0; i < numCells; i++) {
+            if (q[i] == 'H') h |= 1ull << i;
+            if (i > 0 && q[i] == 'H' && q[i - 1] == 'H') bonded++;
+        }
+        hydrophobic.push_back(h);
+        bondedPairs.push_back(bonded);
+    }
+    maximum.assign(proteins.size(), -1);
+    maxPaths.assign(proteins.size(), vector<unsigned char>());
+
+    pthread_mutex_init(&mutex, 0);
+    unsigned long long start = rdtsc();
+
+    // Splitting the work into starting paths, long enough that every thread has plenty to pull from
+    Search search;
+    splitDepth = 0;
+    numPieces = 0;
+    while (splitDepth < numCells && numPieces < NUMTHREADS * PIECES_PER_THREAD) {
+        splitDepth++;
+        pieces.clear();
+        numPieces = 0;
+        for (int cell = 0; cell < numCells; cell++) {
+            unsigned tied;
+            if (!canStart(cell, tied)) continue;
+            collectPieces(search, startAt(search, cell, tied));
+        }
+    }
+
+    pthread_t threads[NUMTHREADS];
+    // Creating the threads
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, parallel_func, NULL);
+    }
+
+    // Waiting for the threads to finish
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    unsigned long long stop = rdtsc();
+
+    for (size_t p = 0; p < proteins.size(); p++) {
+        cout << proteins[p] << " " << maximum[p] << " " << pathToFold(maxPaths[p]) << endl;
+    }
+    cout << totalPaths << " " << stop - start << endl;
+
+    pthread_mutex_destroy(&mutex);
+}
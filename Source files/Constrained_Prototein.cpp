@@ -0,0 +1,386 @@
+/*
+This is a program that calculates the Maximum number of H-H contacts for an n-length prototein over only the folds
+that meet some constraints, instead of finding the best fold and filtering afterwards. There are two kinds:
+    contact i j   residues i and j have to end up next to each other (i and j counted from 0)
+    block x y     the cell at (x, y) can't be used. Residue 0 sits at (0, 0) and y goes up (north), so this is how to
+                  wall off part of the lattice, a membrane for example
+They're read from a file, one per line, with anything after a # ignored.
+
+The constraints are checked as the walk grows, so a walk gets cut the moment it can't meet them:
+    - a residue with a required partner that's already placed has to go right next to it
+    - for every required pair with one residue placed and the other still to come, the one still to come has to be
+      able to get next to the placed one in the steps left (the distance from the end of the walk to the placed one
+      can be at most the steps left plus one), and the placed one has to still have a free cell next to it
+    - blocked cells are just filled in before the search starts
+Two residues can only touch if one is at an even position and the other at an odd one, so a pair that isn't is
+rejected up front.
+
+The rest is a branch and bound with the same bound as my beam search, with the best score shared between threads and
+the starting walks split among the 20 threads. Without blocked cells the walk starts north and the first turn is a left
+like the optimized versions, since required contacts don't care about rotations or mirror images. Blocked cells do, so
+with any of those every direction and both mirror images get searched.
+
+Usage: Constrained_Prototein <prototein> [constraint file]
+Output: <maximum> <clock cycles> (-1 if no fold meets the constraints), and on standard error the fold in F/L/R notation
+with the direction of its first move
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <cstdint>
+using namespace std;
+
+#define FORWARD 0
+#define LEFT 1
+#define RIGHT 2
+
+#define WEST 0
+#define NORTH 1
+#define EAST 2
+#define SOUTH 3
+
+#define NUMTHREADS 20
+#define MAXLEN 32
+
+// Roughly how many starting walks each thread gets
+#define PIECES_PER_THREAD 16
+
+// Initializing global variables
+char *prototein;
+int protoLen;
+int gridSize;
+int center;
+bool symmetric = true;
+vector<pair<int, int> > required;
+vector<int> partnersBefore[MAXLEN];
+vector<pair<int, int> > blocked;
+int bound[MAXLEN + 1];
+int splitDepth;
+vector<unsigned char> pieces;
+int numPieces;
+int nextPiece = 0;
+int maximum = -1;
+uint64_t maxMoves = 0;
+int maxFirstDir = NORTH;
+pthread_mutex_t mutex;
+
+const int rowStep[4] = {0, -1, 0, 1};
+const int colStep[4] = {-1, 0, 1, 0};
+const char *dirNames[4] = {"west", "north", "east", "south"};
+
+// Everything one thread needs. grid has the residue letter in every placed cell, # in blocked ones.
+struct Search {
+    vector<char> grid;
+    vector<int> cells;
+    uint64_t moves;
+    int firstDir;
+};
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+// bound[k] is the most that residues k through protoLen - 1 can add, worked out like Beam_Search_Prototein's
+void buildBound() {
+    bound[protoLen] = 0;
+    for (int j = protoLen - 1; j >= 0; j--) {
+        int most = 0;
+        if (prototein[j] == 'H' && j > 0) {
+            int otherParity = 0;
+            for (int i = (j % 2 == 0) ? 1 : 0; i < j - 1; i += 2) {
+                if (prototein[i] == 'H') otherParity++;
+            }
+            int touches = min(j == protoLen - 1 ? 3 : 2, otherParity);
+            most = 2 * (touches + (prototein[j - 1] == 'H'));
+        }
+        bound[j] = bound[j + 1] + most;
+    }
+}
+
+string movesToFold(uint64_t moves) {
+    string fold = "";
+    for (int i = 0; i < protoLen - 1; i++) {
+        fold += "FLR"[(moves >> (2 * i)) & 3];
+    }
+    return fold;
+}
+
+// Reads the constraint file. Returns false, after saying why, if something in it is wrong.
+bool readConstraints(const char *path) {
+    ifstream in(path);
+    if (!in) {
+        cout << "Couldn't open " << path << endl;
+        return false;
+    }
+    string line;
+    int lineNumber = 0;
+    while (getline(in, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != string::npos) line = line.substr(0, comment);
+        istringstream words(line);
+        string kind;
+        if (!(words >> kind)) continue;
+
+        int a, b;
+        if (!(words >> a >> b) || (kind != "contact" && kind != "block")) {
+            cout << "Line " << lineNumber << " should be \"contact i j\" or \"block x y\"" << endl;
+            return false;
+        }
+        if (kind == "contact") {
+            if (a > b) swap(a, b);
+            if (a < 0 || b >= protoLen || a == b) {
+                cout << "Line " << lineNumber << ": residues go from 0 to " << protoLen - 1 << endl;
+                return false;
+            }
+            // Bonded residues are always next to each other
+            if (b - a == 1) continue;
+            if ((b - a) % 2 == 0) {
+                cout << "Line " << lineNumber << ": residues " << a << " and " << b << " can never touch" << endl;
+                return false;
+            }
+            required.push_back(make_pair(a, b));
+            partnersBefore[b].push_back(a);
+        } else {
+            if (a == 0 && b == 0) {
+                cout << "Line " << lineNumber << ": residue 0 sits at (0, 0), it can't be blocked" << endl;
+                return false;
+            }
+            blocked.push_back(make_pair(a, b));
+        }
+    }
+    return true;
+}
+
+int contactsAt(const Search &s, int pos) {
+    return 2 * ((s.grid[pos - 1] == 'H') + (s.grid[pos + 1] == 'H') +
+                (s.grid[pos - gridSize] == 'H') + (s.grid[pos + gridSize] == 'H'));
+}
+
+inline int distance(int a, int b) {
+    return abs(a / gridSize - b / gridSize) + abs(a % gridSize - b % gridSize);
+}
+
+// Can residue k go at pos? It has to be free and next to any partner it has that's already placed.
+inline bool fits(const Search &s, int k, int pos) {
+    if (s.grid[pos] != '.') return false;
+    for (size_t p = 0; p < partnersBefore[k].size(); p++) {
+        if (distance(pos, s.cells[partnersBefore[k][p]]) != 1) return false;
+    }
+    return true;
+}
+
+// With residue k just placed, can every pair that's half placed still be completed?
+inline bool reachable(const Search &s, int k) {
+    for (size_t p = 0; p < required.size(); p++) {
+        int i = required[p].first;
+        int j = required[p].second;
+        if (i > k || j <= k) continue;
+        int partner = s.cells[i];
+        if (distance(s.cells[k], partner) > j - k + 1) return false;
+        if (s.grid[partner - 1] != '.' && s.grid[partner + 1] != '.' &&
+            s.grid[partner - gridSize] != '.' && s.grid[partner + gridSize] != '.') return false;
+    }
+    return true;
+}
+
+// Tries placing residue k in direction d from pos. Returns the cell, or -1 if it breaks a constraint.
+inline int tryPlace(Search &s, int k, int pos, int d) {
+    int next = pos + rowStep[d] * gridSize + colStep[d];
+    if (!fits(s, k, next)) return -1;
+    s.grid[next] = prototein[k];
+    s.cells[k] = next;
+    if (!reachable(s, k)) {
+        s.grid[next] = '.';
+        return -1;
+    }
+    return next;
+}
+
+// Directions residue k can go from dir. Residue 1 picks an absolute direction, the rest turn.
+inline int directionFor(int k, int dir, int option) {
+    if (k == 1) return option;
+    if (option == LEFT) return (dir + 3) % 4;
+    if (option == RIGHT) return (dir + 1) % 4;
+    return dir;
+}
+
+inline bool skipOption(int k, int option, bool turned) {
+    if (k == 1) return option > SOUTH || (symmetric && option != NORTH);
+    if (option > RIGHT) return true;
+    // Mirror images only get searched once
+    return !turned && option == RIGHT;
+}
+
+// Places residues k through protoLen - 1
+void dfs(Search &s, int k, int pos, int dir, bool turned, int score) {
+    if (k == protoLen) {
+        if (score > __atomic_load_n(&maximum, __ATOMIC_RELAXED)) {
+            pthread_mutex_lock(&mutex);
+            if (score > maximum) {
+                __atomic_store_n(&maximum, score, __ATOMIC_RELAXED);
+                maxMoves = s.moves;
+                maxFirstDir = s.firstDir;
+            }
+            pthread_mutex_unlock(&mutex);
+        }
+        return;
+    }
+    // Another thread may have found something better, reading it without the lock is fine since it only goes up
+    if (score + bound[k] <= __atomic_load_n(&maximum, __ATOMIC_RELAXED)) return;
+
+    for (int option = 0; option < 4; option++) {
+        if (skipOption(k, option, turned)) continue;
+        int d = directionFor(k, dir, option);
+        int next = tryPlace(s, k, pos, d);
+        if (next < 0) continue;
+
+        uint64_t saved = s.moves;
+        if (k == 1) s.firstDir = d;
+        else s.moves |= (uint64_t) option << (2 * (k - 1));
+        int gained = prototein[k] == 'H' ? contactsAt(s, next) : 0;
+        dfs(s, k + 1, next, d, turned || (k > 1 && option != FORWARD), score + gained);
+        s.moves = saved;
+        s.grid[next] = '.';
+    }
+}
+
+// Starting walks are stored as the option taken for each of residues 1 through splitDepth
+void collectPieces(Search &s, int k, int pos, int dir, bool turned, vector<unsigned char> &current) {
+    if ((int) current.size() == splitDepth) {
+        pieces.insert(pieces.end(), current.begin(), current.end());
+        numPieces++;
+        return;
+    }
+    for (int option = 0; option < 4; option++) {
+        if (skipOption(k, option, turned)) continue;
+        int d = directionFor(k, dir, option);
+        int next = tryPlace(s, k, pos, d);
+        if (next < 0) continue;
+        current.push_back(option);
+        collectPieces(s, k + 1, next, d, turned || (k > 1 && option != FORWARD), current);
+        current.pop_back();
+        s.grid[next] = '.';
+    }
+}
+
+void startSearch(Search &s) {
+    s.grid.assign(gridSize * gridSize, '.');
+    for (size_t b = 0; b < blocked.size(); b++) {
+        int x = blocked[b].first;
+        int y = blocked[b].second;
+        // Cells further out than the walk can reach don't matter
+        if (abs(x) > protoLen || abs(y) > protoLen) continue;
+        s.grid[center - y * gridSize + x] = '#';
+    }
+    s.cells.assign(protoLen, -1);
+    s.moves = FORWARD;
+    s.firstDir = NORTH;
+    s.grid[center] = prototein[0];
+    s.cells[0] = center;
+}
+
+void *parallel_func(void *){
+    Search s;
+    startSearch(s);
+    // Without symmetry the walk counts as already turned, so rights are never skipped
+    bool startTurned = !symmetric;
+
+    while (true) {
+        pthread_mutex_lock(&mutex);
+        int piece = nextPiece++;
+        pthread_mutex_unlock(&mutex);
+        if (piece >= numPieces) break;
+
+        // Replaying the starting walk, which already passed every check when it was collected
+        const unsigned char *options = pieces.data() + (size_t) piece * splitDepth;
+        int pos = center;
+        int dir = NORTH;
+        bool turned = startTurned;
+        int score = 0;
+        s.moves = FORWARD;
+        for (int i = 0; i < splitDepth; i++) {
+            int k = i + 1;
+            int d = directionFor(k, dir, options[i]);
+            pos += rowStep[d] * gridSize + colStep[d];
+            s.grid[pos] = prototein[k];
+            s.cells[k] = pos;
+            if (k == 1) s.firstDir = d;
+            else s.moves |= (uint64_t) options[i] << (2 * (k - 1));
+            if (prototein[k] == 'H') score += contactsAt(s, pos);
+            turned = turned || (k > 1 && options[i] != FORWARD);
+            dir = d;
+        }
+
+        dfs(s, splitDepth + 1, pos, dir, turned, score);
+
+        for (int k = 1; k <= splitDepth; k++) s.grid[s.cells[k]] = '.';
+    }
+
+    pthread_exit(NULL);
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <prototein> [constraint file]" << endl;
+        return 1;
+    }
+    prototein = argv[1];
+    protoLen = strlen(argv[1]);
+    if (protoLen < 2 || protoLen > MAXLEN) {
+        cout << "This program handles protoeins from 2 to " << MAXLEN << " long" << endl;
+        return 1;
+    }
+    if (argc > 2 && !readConstraints(argv[2])) return 1;
+    symmetric = blocked.empty();
+
+    // Everything ends up within protoLen of residue 0, plus a border so neighbours never fall off
+    gridSize = (2 * protoLen) + 3;
+    center = (protoLen + 1) * gridSize + protoLen + 1;
+    buildBound();
+
+    pthread_mutex_init(&mutex, 0);
+    unsigned long long start = rdtsc();
+
+    // Splitting the work into starting walks, deep enough that every thread has plenty to pull from
+    Search s;
+    startSearch(s);
+    splitDepth = 0;
+    numPieces = 1;
+    while (splitDepth < protoLen - 1 && numPieces < NUMTHREADS * PIECES_PER_THREAD) {
+        splitDepth++;
+        pieces.clear();
+        numPieces = 0;
+        vector<unsigned char> current;
+        collectPieces(s, 1, center, NORTH, !symmetric, current);
+    }
+
+    pthread_t threads[NUMTHREADS];
+    // Creating the threads
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, parallel_func, NULL);
+    }
+
+    // Waiting for the threads to finish
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    unsigned long long stop = rdtsc();
+
+    cout << maximum << " " << stop - start << endl;
+    if (maximum < 0) cerr << "no fold meets the constraints" << endl;
+    else cerr << "fold: " << movesToFold(maxMoves) << " first move: " << dirNames[maxFirstDir] << endl;
+
+    pthread_mutex_destroy(&mutex);
+}
@@ -0,0 +1,288 @@
+/*
+This is a program that calculates the minimum energy for an n-length prototein over any alphabet, not just H and P. It
+uses the same walk enumeration as my optimized parallel version (first move north, only forward, left, and right after
+that, split across 20 threads), but instead of comparing characters against 'H' it encodes every residue as a small
+integer and looks up each contact's energy in a table.
+
+The energy table is read from a file at startup. The first non-comment line is the alphabet (for example HPNX), and it
+is followed by one row of numbers per letter. Lines starting with # are ignored. Entry [a][b] is the energy of a
+non-bonded contact between a residue of type a and a residue of type b, and has to be the same as [b][a] (a file
+where it isn't gets turned down). Energies are stored as whole numbers of thousandths (ENERGY_SCALE), so everything
+after loading is integer adds and anything past the third decimal place is rounded off. Without a file, the program
+uses the plain HP model: H-H = -1, everything else = 0. Under that matrix the minimum energy is minus the number of
+non-bonded H-H contacts, so it finds the same folds as the HP-only programs. Example for HPNX:
+
+    HPNX
+    -4  0  0  0
+     0  1 -1  0
+     0 -1  1  0
+     0  0  0  0
+
+The table has an extra row and column of zeros for code 0, which is what an empty lattice cell holds. That means
+scoring a residue is just four lookups of neighbouring cells into its table row, with no branches, and the
+empty-cell and H-P cases cost the same as the H-H case. Because the bonded neighbours also show up in these lookups,
+their energy (which is the same for every fold) is worked out once up front and subtracted at the end.
+
+Usage: Energy_Matrix_Prototein <prototein> [energy matrix file]
+Output: <minimum energy> <clock cycles>
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <cstdint>
+using namespace std;
+
+#define FORWARD 0
+#define LEFT 1
+#define RIGHT 2
+
+#define WEST 0
+#define NORTH 1
+#define EAST 2
+#define SOUTH 3
+
+#define NUMTHREADS 20
+
+// 20 amino acids plus a few extras, code 0 is reserved for an empty cell
+#define MAXALPHA 24
+
+// Energies are kept as whole numbers of thousandths so scoring is integer adds
+#define ENERGY_SCALE 1000
+
+// Initializing global variables
+char *prototein;
+int protoLen;
+int numWalks;
+int gridSize;
+string alphabet = "HP";
+int32_t energy[MAXALPHA + 1][MAXALPHA + 1];
+unsigned char *code;
+int bondedEnergy = 0;
+int minimum = 0;
+int minLabel = -1;
+pthread_mutex_t mutex;
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+// A contact's energy can't depend on which of its two residues was placed first, otherwise the same fold would score
+// differently depending on which end it was walked from. Returns false and names the first pair that doesn't match.
+bool symmetricMatrix(string &mismatch) {
+    for (int a = 1; a <= (int) alphabet.size(); a++) {
+        for (int b = a + 1; b <= (int) alphabet.size(); b++) {
+            if (energy[a][b] != energy[b][a]) {
+                mismatch = string(1, alphabet[a - 1]) + "-" + alphabet[b - 1] + " and " + alphabet[b - 1] + "-" +
+                           alphabet[a - 1];
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Reads the alphabet and the energy matrix. Returns false if the file is missing or malformed.
+bool loadMatrix(const char *fileName) {
+    ifstream in(fileName);
+    if (!in) return false;
+
+    string line;
+    int row = -1;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        istringstream fields(line);
+        if (row == -1) {
+            fields >> alphabet;
+            if (alphabet.empty() || (int) alphabet.size() > MAXALPHA) return false;
+        } else {
+            if (row >= (int) alphabet.size()) return false;
+            for (int col = 0; col < (int) alphabet.size(); col++) {
+                double value;
+                if (!(fields >> value)) return false;
+                energy[row + 1][col + 1] = (int32_t) lround(value * ENERGY_SCALE);
+            }
+        }
+        row++;
+    }
+    return row == (int) alphabet.size();
+}
+
+// Turns every letter of the prototein into its index in the alphabet (starting at 1). Returns false on unknown letters.
+bool encodePrototein() {
+    code = new unsigned char[protoLen];
+    for (int i = 0; i < protoLen; i++) {
+        size_t pos = alphabet.find(prototein[i]);
+        if (pos == string::npos) return false;
+        code[i] = (unsigned char) (pos + 1);
+    }
+    for (int i = 1; i < protoLen; i++) {
+        bondedEnergy += energy[code[i - 1]][code[i]];
+    }
+    return true;
+}
+
+// This turns the base 10 label of the walk into base 3
+void labelToWalk(int label, int *walk) {
+    for (int i = protoLen - 2; i >= 0; i--) {
+        walk[i] = label % 3;
+        label = label / 3;
+    }
+}
+
+// Places the walk on the grid and adds up the contact energies as it goes. Each residue only looks at its
+// four neighbours, and since it is placed after the residues it touches, every contact is counted once.
+// Returns false if the walk is not self avoiding. The grid is handed back empty either way.
+bool score(unsigned char *graph, int *cells, int *walk, int &e) {
+    // Row offsets of west, north, east, south in the flattened grid
+    const int step[4] = {-1, -gridSize, 1, gridSize};
+
+    int pos = protoLen * gridSize + protoLen;
+    int dir = NORTH;
+    bool avoiding = true;
+    int total = 0;
+
+    graph[pos] = code[0];
+    cells[0] = pos;
+    int placed = 1;
+
+    for (int i = 1; i < protoLen; i++) {
+        // Left turns counter clockwise, right turns clockwise, forward keeps the heading
+        if (walk[i - 1] == LEFT) dir = (dir + 3) % 4;
+        if (walk[i - 1] == RIGHT) dir = (dir + 1) % 4;
+        pos += step[dir];
+
+        if (graph[pos] != 0) {
+            avoiding = false;
+            break;
+        }
+
+        // The table gather. Empty cells hit the zero column, so no branches are needed. An AVX2 gather of the four
+        // entries was tried and came out slower than four plain loads, there aren't enough of them to fill a vector.
+        const int32_t *row = energy[code[i]];
+        total += row[graph[pos - 1]] + row[graph[pos - gridSize]] + row[graph[pos + 1]] + row[graph[pos + gridSize]];
+
+        graph[pos] = code[i];
+        cells[placed++] = pos;
+    }
+
+    // Only the cells this walk touched need clearing, not the whole grid
+    for (int i = 0; i < placed; i++) {
+        graph[cells[i]] = 0;
+    }
+
+    e = total - bondedEnergy;
+    return avoiding;
+}
+
+void *parallel_func(void *threadid){
+    uintptr_t tid = reinterpret_cast<uintptr_t>(threadid);
+    int segmentSize = numWalks / NUMTHREADS;
+    int startPos;
+    int stopPos;
+    int localMinimum = 0;
+    int localMinLabel = -1;
+
+    // Divvying up the walks. Works with all combinations of prototein lengths and number of thread
+    if (tid < (NUMTHREADS - 1)) {
+        startPos = segmentSize * tid;
+        stopPos = (segmentSize * (tid + 1) - 1);
+    } else {
+        startPos = segmentSize * tid;
+        stopPos = numWalks - 1;
+    }
+
+    // Each thread gets its own grid and walk, the grid starts empty and score() leaves it empty
+    unsigned char *graph = new unsigned char[gridSize * gridSize]();
+    int *cells = new int[protoLen];
+    int *walk = new int[protoLen - 1];
+
+    for (int i = startPos; i <= stopPos; i++){
+        labelToWalk(i, walk);
+        int e;
+        if (!score(graph, cells, walk, e)) continue;
+        if (localMinLabel == -1 || e < localMinimum) {
+            localMinimum = e;
+            localMinLabel = i;
+        }
+    }
+
+    delete[] graph;
+    delete[] cells;
+    delete[] walk;
+
+    // These mutex's are required for this function to be thread safe. Should not really impact performance because its only called 20 times.
+    pthread_mutex_lock(&mutex);
+    if (localMinLabel != -1 && (minLabel == -1 || localMinimum < minimum)) {
+        minimum = localMinimum;
+        minLabel = localMinLabel;
+    }
+    pthread_mutex_unlock(&mutex);
+
+    pthread_exit(NULL);
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <prototein> [energy matrix file]" << endl;
+        return 1;
+    }
+
+    prototein = argv[1];
+    protoLen = strlen(argv[1]);
+    if (protoLen < 2) {
+        cout << "The prototein needs at least 2 residues" << endl;
+        return 1;
+    }
+
+    // Default HP model, anything else comes from the matrix file
+    energy[1][1] = -ENERGY_SCALE;
+    if (argc > 2 && !loadMatrix(argv[2])) {
+        cout << "Could not read energy matrix from " << argv[2] << endl;
+        return 1;
+    }
+    string mismatch;
+    if (!symmetricMatrix(mismatch)) {
+        cout << "Energy matrix has to be symmetric, " << mismatch << " have different energies" << endl;
+        return 1;
+    }
+    if (!encodePrototein()) {
+        cout << "Prototein has a residue that is not in the alphabet " << alphabet << endl;
+        return 1;
+    }
+
+    // The first move is always forward (north), so only the other protoLen - 2 moves are enumerated
+    numWalks = 1;
+    for (int i = 0; i < protoLen - 2; i++) numWalks *= 3;
+
+    // Big enough that a walk starting at the center can never reach the border, so neighbours are always in bounds
+    gridSize = (2 * protoLen) + 1;
+
+    pthread_t threads[NUMTHREADS];
+    pthread_mutex_init(&mutex, 0);
+
+    unsigned long long start = rdtsc();
+    // Creating the threads
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, parallel_func, (void *)t);
+    }
+
+    // Waiting for the threads to finish
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    unsigned long long stop = rdtsc();
+
+    cout << (double) minimum / ENERGY_SCALE << " " << stop - start << endl;
+
+    pthread_mutex_destroy(&mutex);
+    delete[] code;
+}
@@ -0,0 +1,276 @@
+/*
+This is a generator for folds, for code that wants to go through the self avoiding walks of some length itself instead
+of reading displayWalk's text output. It's a C++20 coroutine, so folds are made one at a time as the caller asks for
+them and it uses the same small amount of memory no matter how many folds there are:
+
+    for (const Fold &fold : generateFolds(16, options)) {
+        ... fold.x[i], fold.y[i], fold.moves[i], fold.score ...
+    }
+
+The Fold handed out lives inside the generator and gets overwritten by the next one, so copy anything you want to keep.
+Coordinates have residue 0 at (0, 0) and y going up (north). Moves use the same forward/left/right numbering as the
+optimized programs, moves[i] being the move that places residue i + 1. Needs -std=c++20.
+
+Options:
+    symmetry    only produce one of each set of folds that are rotations or mirror images of each other (first move
+                north, first turn left). On by default.
+    prototein   if set, every fold gets scored against it (every H-H neighbour counts twice, like the other programs).
+    minScore    with a prototein, skips any partial fold that can't reach this score. The bound on what the remaining
+                residues can add is the same one my beam search uses.
+    keepPartial if set, called with each partial fold and the number of residues placed so far. Returning false skips
+                everything that would grow out of it.
+
+To use several threads, give each one its own part of the same set of folds:
+    generateFolds(length, options, part, parts)
+Folds are split by their first few moves, so the parts don't overlap and together they cover every fold once, even
+when keepPartial gives different answers in different threads.
+
+@author: Owen Sheed
+*/
+#ifndef FOLD_GENERATOR_H
+#define FOLD_GENERATOR_H
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <string.h>
+
+#define FOLD_FORWARD 0
+#define FOLD_LEFT 1
+#define FOLD_RIGHT 2
+#define FOLD_MAXLEN 32
+
+// A minimal generator: a coroutine that hands out references to values it owns, one per resume
+template <typename T>
+class Generator {
+public:
+    struct promise_type {
+        const T *current = nullptr;
+
+        Generator get_return_object() {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(const T &value) noexcept {
+            current = &value;
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { throw; }
+    };
+
+    class iterator {
+    public:
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        explicit iterator(std::coroutine_handle<promise_type> h) : handle(h) {}
+
+        const T &operator*() const { return *handle.promise().current; }
+        const T *operator->() const { return handle.promise().current; }
+        iterator &operator++() {
+            handle.resume();
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(std::default_sentinel_t) const { return !handle || handle.done(); }
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    explicit Generator(std::coroutine_handle<promise_type> h) : handle(h) {}
+    Generator(Generator &&other) noexcept : handle(std::exchange(other.handle, {})) {}
+    Generator(const Generator &) = delete;
+    Generator &operator=(const Generator &) = delete;
+    ~Generator() {
+        if (handle) handle.destroy();
+    }
+
+    iterator begin() {
+        if (handle) handle.resume();
+        return iterator(handle);
+    }
+    std::default_sentinel_t end() { return {}; }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+struct Fold {
+    int length;
+    int x[FOLD_MAXLEN];
+    int y[FOLD_MAXLEN];
+    int moves[FOLD_MAXLEN];
+    int score;
+};
+
+struct FoldOptions {
+    bool symmetry = true;
+    const char *prototein = nullptr;
+    int minScore = -1;
+    std::function<bool(const Fold &, int)> keepPartial;
+};
+
+// A fold's moves in F/L/R notation
+inline std::string foldString(const Fold &fold) {
+    std::string s;
+    for (int i = 0; i < fold.length - 1; i++) s += "FLR"[fold.moves[i]];
+    return s;
+}
+
+// Most that residues k through length - 1 can still add, same bound as Beam_Search_Prototein
+inline void foldBound(const char *prototein, int length, int *bound) {
+    bound[length] = 0;
+    for (int j = length - 1; j >= 0; j--) {
+        int most = 0;
+        if (prototein[j] == 'H' && j > 0) {
+            int otherParity = 0;
+            for (int i = (j % 2 == 0) ? 1 : 0; i < j - 1; i += 2) {
+                if (prototein[i] == 'H') otherParity++;
+            }
+            int touches = (j == length - 1) ? 3 : 2;
+            if (otherParity < touches) touches = otherParity;
+            most = 2 * (touches + (prototein[j - 1] == 'H'));
+        }
+        bound[j] = bound[j + 1] + most;
+    }
+}
+
+// How many moves in a fold has to be split on to give every part plenty of folds
+inline int foldSplitDepth(int length, int parts) {
+    if (parts <= 1) return 0;
+    int depth = 0;
+    long long prefixes = 1;
+    while (depth < length - 2 && prefixes < 16ll * parts) {
+        depth++;
+        prefixes *= 3;
+    }
+    return depth;
+}
+
+// Every self avoiding fold of the given length, or just this thread's share of them. Depth first with an explicit
+// stack, so memory doesn't depend on the number of folds.
+inline Generator<Fold> generateFolds(int length, FoldOptions options = FoldOptions(), int part = 0, int parts = 1) {
+    if (length < 1 || length > FOLD_MAXLEN) co_return;
+
+    const int dx[4] = {-1, 0, 1, 0};
+    const int dy[4] = {0, 1, 0, -1};
+    const int north = 1;
+    const int size = 2 * FOLD_MAXLEN + 1;
+    const int center = FOLD_MAXLEN;
+    const char *prototein = options.prototein;
+
+    // Residue index + 1 in every occupied cell, 0 if empty
+    unsigned char grid[size][size];
+    memset(grid, 0, sizeof(grid));
+
+    int bound[FOLD_MAXLEN + 1];
+    if (prototein != nullptr) foldBound(prototein, length, bound);
+
+    Fold fold;
+    fold.length = length;
+    fold.x[0] = 0;
+    fold.y[0] = 0;
+    fold.score = 0;
+    grid[center][center] = 1;
+
+    if (length == 1) {
+        if (part == 0) co_yield fold;
+        co_return;
+    }
+
+    // Folds are handed out to the parts by their moves up to this point
+    int splitDepth = foldSplitDepth(length, parts);
+
+    // The stack: for residue k, the direction it was placed in, whether the fold has turned yet, the score so far,
+    // and the next move to try from it.
+    int dir[FOLD_MAXLEN];
+    bool turned[FOLD_MAXLEN];
+    int score[FOLD_MAXLEN];
+    int nextMove[FOLD_MAXLEN];
+
+    // Residue 1 always goes north when symmetry is on, otherwise residue 0 gets to try all 4 directions
+    int firstDirs = options.symmetry ? 1 : 4;
+    for (int first = 0; first < firstDirs; first++) {
+        int d0 = options.symmetry ? north : first;
+        fold.x[1] = dx[d0];
+        fold.y[1] = dy[d0];
+        fold.moves[0] = FOLD_FORWARD;
+        grid[center + fold.y[1]][center + fold.x[1]] = 2;
+        dir[1] = d0;
+        turned[1] = !options.symmetry;
+        score[1] = (prototein != nullptr && prototein[0] == 'H' && prototein[1] == 'H') ? 2 : 0;
+        nextMove[1] = FOLD_FORWARD;
+
+        int k = 1;
+        bool descend = true;
+        while (k >= 1) {
+            // Deciding whether the fold ending at residue k gets yielded or grown
+            if (descend) {
+                descend = false;
+                fold.score = score[k];
+                bool keep = true;
+                if (parts > 1 && k == splitDepth + 1) {
+                    // The prefix's own moves decide which part it belongs to, so every part agrees no matter
+                    // what the filters below skip
+                    long long prefix = first;
+                    for (int i = 1; i <= splitDepth; i++) prefix = prefix * 3 + fold.moves[i];
+                    keep = (prefix % parts) == part;
+                }
+                if (keep && prototein != nullptr && options.minScore >= 0 && score[k] + bound[k + 1] < options.minScore) keep = false;
+                if (keep && options.keepPartial && !options.keepPartial(fold, k + 1)) keep = false;
+                if (!keep) {
+                    nextMove[k] = 3;
+                } else if (k == length - 1) {
+                    co_yield fold;
+                    nextMove[k] = 3;
+                }
+            }
+
+            // Trying the next move from residue k, or backing up if there aren't any left
+            if (nextMove[k] > FOLD_RIGHT) {
+                grid[center + fold.y[k]][center + fold.x[k]] = 0;
+                k--;
+                continue;
+            }
+            int m = nextMove[k]++;
+            if (!turned[k] && m == FOLD_RIGHT) continue;
+
+            int d = dir[k];
+            if (m == FOLD_LEFT) d = (d + 3) % 4;
+            if (m == FOLD_RIGHT) d = (d + 1) % 4;
+            int nx = fold.x[k] + dx[d];
+            int ny = fold.y[k] + dy[d];
+            if (grid[center + ny][center + nx] != 0) continue;
+
+            int gained = 0;
+            if (prototein != nullptr && prototein[k + 1] == 'H') {
+                for (int n = 0; n < 4; n++) {
+                    int other = grid[center + ny + dy[n]][center + nx + dx[n]];
+                    if (other != 0 && prototein[other - 1] == 'H') gained += 2;
+                }
+            }
+
+            k++;
+            fold.x[k] = nx;
+            fold.y[k] = ny;
+            fold.moves[k - 1] = m;
+            grid[center + ny][center + nx] = k + 1;
+            dir[k] = d;
+            turned[k] = turned[k - 1] || m != FOLD_FORWARD;
+            score[k] = score[k - 1] + gained;
+            nextMove[k] = FOLD_FORWARD;
+            descend = true;
+        }
+        // Residue 0 stays put for the next starting direction
+        grid[center][center] = 1;
+    }
+}
+
+#endif
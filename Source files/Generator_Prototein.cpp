@@ -0,0 +1,92 @@
+/*
+This is a program that calculates the Maximum number of H-H contacts for an n-length prototein using the fold generator
+in Fold_Generator.h, mostly as an example of how to use it. Each of the 20 threads takes its own part of the folds and
+keeps the best one it sees. The partial fold filter is used as a branch and bound: a partial fold only gets grown if
+its score plus the most the remaining residues could add beats the best score any thread has found so far.
+
+Build with -std=c++20 (the generator is a coroutine).
+
+Usage: Generator_Prototein <prototein>
+Output: <maximum> <clock cycles>, and the fold in F/L/R notation on standard error
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <string>
+#include <string.h>
+#include <pthread.h>
+#include <cstdint>
+#include "Fold_Generator.h"
+using namespace std;
+
+#define NUMTHREADS 20
+
+// Initializing global variables
+char *prototein;
+int protoLen;
+int bound[FOLD_MAXLEN + 1];
+int maximum = -1;
+string maxFold;
+pthread_mutex_t mutex;
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+void *parallel_func(void *threadid){
+    uintptr_t tid = reinterpret_cast<uintptr_t>(threadid);
+
+    FoldOptions options;
+    options.prototein = prototein;
+    options.keepPartial = [](const Fold &fold, int placed) {
+        return fold.score + bound[placed] > __atomic_load_n(&maximum, __ATOMIC_RELAXED);
+    };
+
+    for (const Fold &fold : generateFolds(protoLen, options, tid, NUMTHREADS)) {
+        pthread_mutex_lock(&mutex);
+        if (fold.score > maximum) {
+            __atomic_store_n(&maximum, fold.score, __ATOMIC_RELAXED);
+            maxFold = foldString(fold);
+        }
+        pthread_mutex_unlock(&mutex);
+    }
+
+    pthread_exit(NULL);
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <prototein>" << endl;
+        return 1;
+    }
+    prototein = argv[1];
+    protoLen = strlen(argv[1]);
+    if (protoLen > FOLD_MAXLEN) {
+        cout << "This program handles protoeins up to " << FOLD_MAXLEN << " long" << endl;
+        return 1;
+    }
+    foldBound(prototein, protoLen, bound);
+
+    pthread_t threads[NUMTHREADS];
+    pthread_mutex_init(&mutex, 0);
+
+    unsigned long long start = rdtsc();
+    // Creating the threads
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, parallel_func, (void *)t);
+    }
+
+    // Waiting for the threads to finish
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    unsigned long long stop = rdtsc();
+
+    cout << maximum << " " << stop - start << endl;
+    cerr << "fold: " << maxFold << endl;
+
+    pthread_mutex_destroy(&mutex);
+}
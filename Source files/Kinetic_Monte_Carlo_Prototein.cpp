@@ -0,0 +1,427 @@
+/*
+This is a program that measures how long a prototein takes to fold, rather than what its best fold is. It runs
+thousands of independent Metropolis Monte Carlo trajectories, each one starting from a straight chain, and records the
+first time each one reaches a target fold (its first passage time). The target is given in the same forward/left/right
+notation the other programs use, and a trajectory counts as there if it matches the target or its mirror image, in any
+rotation.
+
+Every step picks a random residue and tries one local move on it:
+    end move     an end residue swings to another free cell next to its neighbour
+    corner flip  a residue at a corner jumps to the opposite corner of the square its two neighbours make
+    crankshaft   a residue and the next one, forming a U with the residues on either side, flip to the other side
+The move is kept if it doesn't lose any H-H contacts, and otherwise with probability exp(-contacts lost / temperature).
+Time is counted in steps (one tried move each). The energy is minus the number of H-H contacts.
+
+Trajectories are run in blocks of 8 that take turns stepping, with their own random number generator each. This isn't
+SIMD: every chain picks its own residue and kind of move, so each one steps on its own with ordinary scalar code. I
+tried storing the bitboards lane-major and doing the free cell and contact checks for all 8 at once, and it gave the
+same trajectories but ran about 1.8 times slower, and GCC didn't vectorize the batched loop even with -O3 -mavx2. The
+blocks are just a way to hand out work and keep 8 chains' worth of state together.
+
+Each chain has a 64x64 bitboard of its occupied cells and one of its H cells, wrapped around so chains can wander
+anywhere. A chain can't span 64 cells, so it never wraps into itself. That makes the self avoiding check and the
+contact change for a move a few bit tests, instead of rescoring the whole grid. The 20 threads take turns pulling
+blocks off a shared counter.
+
+Checking the whole chain against the target on every step would be slow, so it's only done when the number of contacts
+matches the target's.
+
+Usage: Kinetic_Monte_Carlo_Prototein <prototein> <target fold> [trajectories] [temperature] [max steps] [seed]
+Output: a histogram of first passage times ("<from> <to> <count>" per bin, doubling in width), how many trajectories
+reached the target, then "<mean first passage time> <clock cycles>"
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <cstdint>
+using namespace std;
+
+#define WEST 0
+#define NORTH 1
+#define EAST 2
+#define SOUTH 3
+
+#define NUMTHREADS 20
+#define MAXLEN 63
+#define LANES 8
+
+#define DEFAULT_TRAJECTORIES 1000
+#define DEFAULT_TEMPERATURE 0.5
+#define DEFAULT_MAXSTEPS 10000000
+
+// A block of LANES chains that take turns stepping. Coordinates are unbounded, the bitboards wrap at 64.
+struct Block {
+    int x[MAXLEN][LANES];
+    int y[MAXLEN][LANES];
+    uint64_t occupied[LANES][64];
+    uint64_t hydrophobic[LANES][64];
+    int contacts[LANES];
+    uint64_t rng[LANES];
+    long long passage[LANES];
+};
+
+// Initializing global variables
+char *prototein;
+int protoLen;
+string target;
+string mirrorTarget;
+int targetContacts;
+int trajectories = DEFAULT_TRAJECTORIES;
+double temperature = DEFAULT_TEMPERATURE;
+long long maxSteps = DEFAULT_MAXSTEPS;
+uint64_t seed = 1;
+double acceptance[9];
+int nextBlock = 0;
+vector<long long> passageTimes;
+pthread_mutex_t mutex;
+
+// West, north, east, south with y going up
+const int dx[4] = {-1, 0, 1, 0};
+const int dy[4] = {0, 1, 0, -1};
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+// splitmix64, used to give every trajectory its own unrelated starting state
+uint64_t splitmix(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// xorshift64*, one per trajectory
+inline uint64_t nextRandom(uint64_t &state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1Dull;
+}
+
+inline double uniform(uint64_t &state) {
+    return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+inline bool isSet(const uint64_t *board, int x, int y) {
+    return (board[y & 63] >> (x & 63)) & 1;
+}
+
+inline void setCell(uint64_t *board, int x, int y) {
+    board[y & 63] |= 1ull << (x & 63);
+}
+
+inline void clearCell(uint64_t *board, int x, int y) {
+    board[y & 63] &= ~(1ull << (x & 63));
+}
+
+inline int hNeighbours(const uint64_t *board, int x, int y) {
+    return isSet(board, x - 1, y) + isSet(board, x + 1, y) + isSet(board, x, y - 1) + isSet(board, x, y + 1);
+}
+
+int direction(int fromX, int fromY, int toX, int toY) {
+    if (toX < fromX) return WEST;
+    if (toY > fromY) return NORTH;
+    if (toX > fromX) return EAST;
+    return SOUTH;
+}
+
+// Does this lane's chain have the target's shape (or its mirror's)? Shapes are compared as F/L/R turns, so rotation
+// doesn't matter.
+bool atTarget(const Block &b, int lane) {
+    bool same = true;
+    bool mirror = true;
+    int previous = direction(b.x[0][lane], b.y[0][lane], b.x[1][lane], b.y[1][lane]);
+    for (int i = 1; i < protoLen - 1 && (same || mirror); i++) {
+        int d = direction(b.x[i][lane], b.y[i][lane], b.x[i + 1][lane], b.y[i + 1][lane]);
+        char turn = 'F';
+        if (d == (previous + 3) % 4) turn = 'L';
+        if (d == (previous + 1) % 4) turn = 'R';
+        same = same && turn == target[i];
+        mirror = mirror && turn == mirrorTarget[i];
+        previous = d;
+    }
+    return same || mirror;
+}
+
+// Moves residue i of a lane to (nx, ny), keeping the bitboards up to date
+inline void moveResidue(Block &b, int lane, int i, int nx, int ny) {
+    clearCell(b.occupied[lane], b.x[i][lane], b.y[i][lane]);
+    setCell(b.occupied[lane], nx, ny);
+    if (prototein[i] == 'H') {
+        clearCell(b.hydrophobic[lane], b.x[i][lane], b.y[i][lane]);
+        setCell(b.hydrophobic[lane], nx, ny);
+    }
+    b.x[i][lane] = nx;
+    b.y[i][lane] = ny;
+}
+
+// Metropolis test on a change in contacts
+inline bool accept(int gained, uint64_t &state) {
+    if (gained >= 0) return true;
+    return uniform(state) < acceptance[-gained];
+}
+
+// One attempted move on one lane
+void step(Block &b, int lane) {
+    uint64_t &rng = b.rng[lane];
+    uint64_t *occupied = b.occupied[lane];
+    uint64_t *hydrophobic = b.hydrophobic[lane];
+    int i = nextRandom(rng) % protoLen;
+    bool h = prototein[i] == 'H';
+    int x = b.x[i][lane];
+    int y = b.y[i][lane];
+
+    if (i == 0 || i == protoLen - 1) {
+        // End move: to a random cell next to the neighbour
+        int n = (i == 0) ? 1 : protoLen - 2;
+        int d = nextRandom(rng) % 4;
+        int nx = b.x[n][lane] + dx[d];
+        int ny = b.y[n][lane] + dy[d];
+        if (isSet(occupied, nx, ny)) return;
+
+        int gained = 0;
+        if (h) {
+            clearCell(hydrophobic, x, y);
+            gained = hNeighbours(hydrophobic, nx, ny) - hNeighbours(hydrophobic, x, y);
+            setCell(hydrophobic, x, y);
+        }
+        if (!accept(gained, rng)) return;
+        moveResidue(b, lane, i, nx, ny);
+        b.contacts[lane] += gained;
+        return;
+    }
+
+    int px = b.x[i - 1][lane];
+    int py = b.y[i - 1][lane];
+    int qx = b.x[i + 1][lane];
+    int qy = b.y[i + 1][lane];
+
+    // A straight stretch can't do a local move
+    if (px == qx || py == qy) return;
+
+    if ((nextRandom(rng) & 1) == 0 || i + 2 >= protoLen) {
+        // Corner flip: to the other corner of the square made with the two neighbours
+        int nx = px + qx - x;
+        int ny = py + qy - y;
+        if (isSet(occupied, nx, ny)) return;
+
+        int gained = 0;
+        if (h) {
+            clearCell(hydrophobic, x, y);
+            gained = hNeighbours(hydrophobic, nx, ny) - hNeighbours(hydrophobic, x, y);
+            setCell(hydrophobic, x, y);
+        }
+        if (!accept(gained, rng)) return;
+        moveResidue(b, lane, i, nx, ny);
+        b.contacts[lane] += gained;
+        return;
+    }
+
+    // Crankshaft on i and i + 1: i - 1 and i + 2 have to be next to each other, with i and i + 1 on one side
+    int j = i + 1;
+    int x2 = b.x[j][lane];
+    int y2 = b.y[j][lane];
+    int rx = b.x[i + 2][lane];
+    int ry = b.y[i + 2][lane];
+    if (abs(px - rx) + abs(py - ry) != 1) return;
+    if (abs(x - x2) + abs(y - y2) != 1) return;
+
+    // Both residues jump twice the distance from the i - 1 / i + 2 bond to the other side
+    int ox = 2 * (px - x);
+    int oy = 2 * (py - y);
+    int nx1 = x + ox;
+    int ny1 = y + oy;
+    int nx2 = x2 + ox;
+    int ny2 = y2 + oy;
+    if (isSet(occupied, nx1, ny1) || isSet(occupied, nx2, ny2)) return;
+
+    bool h2 = prototein[j] == 'H';
+    int gained = 0;
+    if (h) clearCell(hydrophobic, x, y);
+    if (h2) clearCell(hydrophobic, x2, y2);
+    if (h) gained -= hNeighbours(hydrophobic, x, y);
+    if (h2) gained -= hNeighbours(hydrophobic, x2, y2);
+    if (h) gained += hNeighbours(hydrophobic, nx1, ny1);
+    if (h2) gained += hNeighbours(hydrophobic, nx2, ny2);
+    if (h) setCell(hydrophobic, x, y);
+    if (h2) setCell(hydrophobic, x2, y2);
+    if (!accept(gained, rng)) return;
+    moveResidue(b, lane, i, nx1, ny1);
+    moveResidue(b, lane, j, nx2, ny2);
+    b.contacts[lane] += gained;
+}
+
+// Straight chain heading east, with every bit set up and a starting random state
+void startBlock(Block &b, int firstTrajectory) {
+    memset(b.occupied, 0, sizeof(b.occupied));
+    memset(b.hydrophobic, 0, sizeof(b.hydrophobic));
+    for (int lane = 0; lane < LANES; lane++) {
+        b.contacts[lane] = 0;
+        for (int i = 0; i < protoLen; i++) {
+            b.x[i][lane] = i;
+            b.y[i][lane] = 0;
+            setCell(b.occupied[lane], i, 0);
+            if (prototein[i] == 'H') {
+                setCell(b.hydrophobic[lane], i, 0);
+                if (i > 0 && prototein[i - 1] == 'H') b.contacts[lane]++;
+            }
+        }
+        b.rng[lane] = splitmix(seed * 1000003 + firstTrajectory + lane);
+        if (b.rng[lane] == 0) b.rng[lane] = 1;
+        b.passage[lane] = -1;
+    }
+}
+
+void *parallel_func(void *){
+    Block *b = new Block();
+    vector<long long> found;
+
+    while (true) {
+        pthread_mutex_lock(&mutex);
+        int block = nextBlock++;
+        pthread_mutex_unlock(&mutex);
+        int first = block * LANES;
+        if (first >= trajectories) break;
+        int lanes = min(LANES, trajectories - first);
+
+        startBlock(*b, first);
+        int running = lanes;
+        for (int lane = 0; lane < lanes; lane++) {
+            if (b->contacts[lane] == targetContacts && atTarget(*b, lane)) {
+                b->passage[lane] = 0;
+                running--;
+            }
+        }
+
+        // The lanes take turns stepping until every one of them has got there or run out of time
+        for (long long t = 1; t <= maxSteps && running > 0; t++) {
+            for (int lane = 0; lane < lanes; lane++) {
+                if (b->passage[lane] >= 0) continue;
+                step(*b, lane);
+                if (b->contacts[lane] == targetContacts && atTarget(*b, lane)) {
+                    b->passage[lane] = t;
+                    running--;
+                }
+            }
+        }
+        for (int lane = 0; lane < lanes; lane++) found.push_back(b->passage[lane]);
+    }
+
+    pthread_mutex_lock(&mutex);
+    passageTimes.insert(passageTimes.end(), found.begin(), found.end());
+    pthread_mutex_unlock(&mutex);
+
+    delete b;
+    pthread_exit(NULL);
+}
+
+// Checks the target is a self avoiding fold of the right length and counts its H-H neighbours (bonded ones included,
+// the same way the chains count theirs)
+bool setTarget(const char *fold) {
+    target = fold;
+    if ((int) target.size() != protoLen - 1) return false;
+    mirrorTarget = target;
+    for (size_t i = 0; i < target.size(); i++) {
+        if (target[i] == 'L') mirrorTarget[i] = 'R';
+        else if (target[i] == 'R') mirrorTarget[i] = 'L';
+        else if (target[i] != 'F') return false;
+    }
+
+    vector<int> xs(protoLen), ys(protoLen);
+    int d = NORTH;
+    for (int i = 1; i < protoLen; i++) {
+        if (i > 1 && target[i - 1] == 'L') d = (d + 3) % 4;
+        if (i > 1 && target[i - 1] == 'R') d = (d + 1) % 4;
+        xs[i] = xs[i - 1] + dx[d];
+        ys[i] = ys[i - 1] + dy[d];
+        for (int j = 0; j < i; j++) {
+            if (xs[j] == xs[i] && ys[j] == ys[i]) return false;
+        }
+    }
+    targetContacts = 0;
+    for (int i = 0; i < protoLen; i++) {
+        for (int j = i + 1; j < protoLen; j++) {
+            if (prototein[i] == 'H' && prototein[j] == 'H' && abs(xs[i] - xs[j]) + abs(ys[i] - ys[j]) == 1) {
+                targetContacts++;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv){
+    if (argc < 3) {
+        cout << "Usage: " << argv[0] << " <prototein> <target fold> [trajectories] [temperature] [max steps] [seed]" << endl;
+        return 1;
+    }
+    prototein = argv[1];
+    protoLen = strlen(argv[1]);
+    if (protoLen < 3 || protoLen > MAXLEN) {
+        cout << "This program handles protoeins from 3 to " << MAXLEN << " long" << endl;
+        return 1;
+    }
+    if (!setTarget(argv[2])) {
+        cout << "Target fold has to be " << protoLen - 1 << " self avoiding F/L/R moves" << endl;
+        return 1;
+    }
+    if (argc > 3) trajectories = max(1, atoi(argv[3]));
+    if (argc > 4) temperature = atof(argv[4]);
+    if (argc > 5) maxSteps = atoll(argv[5]);
+    if (argc > 6) seed = strtoull(argv[6], NULL, 10);
+
+    // Chance of keeping a move that loses this many contacts
+    for (int lost = 0; lost < 9; lost++) {
+        acceptance[lost] = temperature > 0 ? exp(-lost / temperature) : (lost == 0);
+    }
+
+    pthread_mutex_init(&mutex, 0);
+    unsigned long long start = rdtsc();
+
+    pthread_t threads[NUMTHREADS];
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, parallel_func, NULL);
+    }
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    unsigned long long stop = rdtsc();
+
+    // Histogram with bins that double in width: [0, 1), [1, 2), [2, 4), ...
+    vector<long long> reached;
+    for (size_t i = 0; i < passageTimes.size(); i++) {
+        if (passageTimes[i] >= 0) reached.push_back(passageTimes[i]);
+    }
+    sort(reached.begin(), reached.end());
+    vector<int> bins(64, 0);
+    double total = 0;
+    for (size_t i = 0; i < reached.size(); i++) {
+        int bin = reached[i] == 0 ? 0 : 64 - __builtin_clzll(reached[i]);
+        bins[bin]++;
+        total += reached[i];
+    }
+    for (int bin = 0; bin < 64; bin++) {
+        if (bins[bin] == 0) continue;
+        long long from = bin == 0 ? 0 : 1ll << (bin - 1);
+        long long to = 1ll << bin;
+        cout << from << " " << to << " " << bins[bin] << endl;
+    }
+    cout << "reached " << reached.size() << " of " << trajectories;
+    if (!reached.empty()) cout << ", median " << reached[reached.size() / 2];
+    cout << endl;
+
+    double mean = reached.empty() ? -1 : total / reached.size();
+    cout << mean << " " << stop - start << endl;
+
+    pthread_mutex_destroy(&mutex);
+}
@@ -0,0 +1,363 @@
+/*
+This is a program that calculates the Maximum number of H-H contacts for a prototein and for every single mutant of it
+(each residue flipped from H to P or P to H), in one search instead of n + 1 runs.
+
+Flipping residue i only changes the contacts i is part of. If i has h H neighbours in some fold (bonded ones
+included), flipping an H to a P loses 2h and flipping a P to an H gains 2h, and nothing else about that fold's score
+changes. h can only be 0 to 4, so for each residue the search keeps best[i][h]: the best score of any fold where
+residue i has h H neighbours, and that fold. The best a mutant at i can do is then the biggest best[i][h] +/- 2h,
+which is exact, and it all comes out of one enumeration of the original prototein's folds.
+
+The H neighbour counts are kept up to date as residues are placed, so a finished fold only costs one pass over its
+residues. The search is a branch and bound: a flip can add at most 8 to a fold, so a partial fold gets skipped when
+its score plus the most the rest of it could add (the same bound as my beam search) plus 8 can't beat the lowest
+answer found so far over the prototein and all its mutants. Each thread's lowest answer is shared, and the biggest of
+them is safe to prune with since every mutant's answer is at least that.
+
+Like the optimized versions every walk starts by going north, and the first turn is always a left (a walk whose first
+turn is a right is the mirror image of one that turns left). The work is split into short starting walks that the 20
+threads take turns pulling off a shared list.
+
+Usage: Mutation_Scan_Prototein <prototein>
+Output: "<prototein> <maximum> <fold>" for the prototein itself, then one "<position> <mutant> <maximum> <fold>" line
+per mutant (positions from 0, folds in F/L/R notation), then "<maximum> <clock cycles>"
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <string.h>
+#include <pthread.h>
+#include <cstdint>
+using namespace std;
+
+#define FORWARD 0
+#define LEFT 1
+#define RIGHT 2
+
+#define WEST 0
+#define NORTH 1
+#define EAST 2
+#define SOUTH 3
+
+#define NUMTHREADS 20
+#define MAXLEN 32
+
+// The most H neighbours a residue can have
+#define MAXNEIGHBOURS 4
+
+// Roughly how many starting walks each thread gets
+#define PIECES_PER_THREAD 16
+
+// Initializing global variables
+char *prototein;
+int protoLen;
+int gridSize;
+int splitDepth;
+vector<unsigned char> pieces;
+int numPieces;
+int nextPiece = 0;
+int bound[MAXLEN + 1];
+int best[MAXLEN][MAXNEIGHBOURS + 1];
+uint64_t bestMoves[MAXLEN][MAXNEIGHBOURS + 1];
+int floorScore = -1;
+pthread_mutex_t mutex;
+
+const int rowStep[4] = {0, -1, 0, 1};
+const int colStep[4] = {-1, 0, 1, 0};
+
+// Everything one thread needs. grid holds residue index + 1 in every occupied cell, neighbours[i] is how many H's
+// residue i is next to.
+struct Search {
+    vector<int> grid;
+    uint64_t moves;
+    int neighbours[MAXLEN];
+    int best[MAXLEN][MAXNEIGHBOURS + 1];
+    uint64_t bestMoves[MAXLEN][MAXNEIGHBOURS + 1];
+    int floor;
+};
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+// bound[k] is the most that residues k through protoLen - 1 can add, worked out like Beam_Search_Prototein's
+void buildBound() {
+    bound[protoLen] = 0;
+    for (int j = protoLen - 1; j >= 0; j--) {
+        int most = 0;
+        if (prototein[j] == 'H' && j > 0) {
+            int otherParity = 0;
+            for (int i = (j % 2 == 0) ? 1 : 0; i < j - 1; i += 2) {
+                if (prototein[i] == 'H') otherParity++;
+            }
+            int touches = min(j == protoLen - 1 ? 3 : 2, otherParity);
+            most = 2 * (touches + (prototein[j - 1] == 'H'));
+        }
+        bound[j] = bound[j + 1] + most;
+    }
+}
+
+string movesToFold(uint64_t moves) {
+    string fold = "";
+    for (int i = 0; i < protoLen - 1; i++) {
+        fold += "FLR"[(moves >> (2 * i)) & 3];
+    }
+    return fold;
+}
+
+// The best the mutant at residue i can do according to a best table
+int mutantBest(const int table[][MAXNEIGHBOURS + 1], int i, int &h) {
+    int result = -1;
+    h = 0;
+    for (int n = 0; n <= MAXNEIGHBOURS; n++) {
+        if (table[i][n] < 0) continue;
+        int score = table[i][n] + (prototein[i] == 'H' ? -2 * n : 2 * n);
+        if (score > result) {
+            result = score;
+            h = n;
+        }
+    }
+    return result;
+}
+
+// The lowest answer so far over the prototein and every mutant
+int lowestAnswer(const Search &s) {
+    int lowest = -1;
+    for (int n = 0; n <= MAXNEIGHBOURS; n++) lowest = max(lowest, s.best[0][n]);
+    int h;
+    for (int i = 0; i < protoLen; i++) lowest = min(lowest, mutantBest(s.best, i, h));
+    return lowest;
+}
+
+// Puts residue k at pos and updates the H neighbour counts, returning what it adds to the score
+inline int place(Search &s, int k, int pos) {
+    s.grid[pos] = k + 1;
+    s.neighbours[k] = 0;
+    int gained = 0;
+    int around[4] = {pos - 1, pos + 1, pos - gridSize, pos + gridSize};
+    for (int d = 0; d < 4; d++) {
+        int other = s.grid[around[d]] - 1;
+        if (other < 0) continue;
+        if (prototein[other] == 'H') s.neighbours[k]++;
+        if (prototein[k] == 'H') {
+            s.neighbours[other]++;
+            if (prototein[other] == 'H') gained += 2;
+        }
+    }
+    return gained;
+}
+
+inline void unplace(Search &s, int k, int pos) {
+    s.grid[pos] = 0;
+    if (prototein[k] != 'H') return;
+    int around[4] = {pos - 1, pos + 1, pos - gridSize, pos + gridSize};
+    for (int d = 0; d < 4; d++) {
+        int other = s.grid[around[d]] - 1;
+        if (other >= 0) s.neighbours[other]--;
+    }
+}
+
+// A full walk: filing it under every residue's H neighbour count
+void leaf(Search &s, int score) {
+    bool changed = false;
+    for (int i = 0; i < protoLen; i++) {
+        int n = s.neighbours[i];
+        if (score > s.best[i][n]) {
+            s.best[i][n] = score;
+            s.bestMoves[i][n] = s.moves;
+            changed = true;
+        }
+    }
+    if (!changed) return;
+
+    int lowest = lowestAnswer(s);
+    if (lowest <= s.floor) return;
+    s.floor = lowest;
+    // Sharing it, but only if it's bigger than what's there
+    int shared = __atomic_load_n(&floorScore, __ATOMIC_RELAXED);
+    while (lowest > shared && !__atomic_compare_exchange_n(&floorScore, &shared, lowest, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+// Places residues k through protoLen - 1
+void dfs(Search &s, int k, int pos, int dir, bool turned, int score) {
+    if (k == protoLen) {
+        leaf(s, score);
+        return;
+    }
+    int floor = max(s.floor, __atomic_load_n(&floorScore, __ATOMIC_RELAXED));
+    if (score + bound[k] + 2 * MAXNEIGHBOURS <= floor) return;
+
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        // Mirror images only get searched once
+        if (!turned && m == RIGHT) continue;
+
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + rowStep[d] * gridSize + colStep[d];
+        if (s.grid[next] != 0) continue;
+
+        int gained = place(s, k, next);
+        uint64_t saved = s.moves;
+        s.moves |= (uint64_t) m << (2 * (k - 1));
+        dfs(s, k + 1, next, d, turned || m != FORWARD, score + gained);
+        s.moves = saved;
+        unplace(s, k, next);
+    }
+}
+
+void collectPieces(vector<char> &grid, int pos, int dir, bool turned, vector<unsigned char> &current) {
+    if ((int) current.size() == splitDepth) {
+        pieces.insert(pieces.end(), current.begin(), current.end());
+        numPieces++;
+        return;
+    }
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        if (!turned && m == RIGHT) continue;
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + rowStep[d] * gridSize + colStep[d];
+        if (grid[next] != '.') continue;
+        grid[next] = 'X';
+        current.push_back(m);
+        collectPieces(grid, next, d, turned || m != FORWARD, current);
+        current.pop_back();
+        grid[next] = '.';
+    }
+}
+
+void *parallel_func(void *){
+    Search s;
+    s.grid.assign(gridSize * gridSize, 0);
+    for (int i = 0; i < protoLen; i++) {
+        for (int n = 0; n <= MAXNEIGHBOURS; n++) {
+            s.best[i][n] = -1;
+            s.bestMoves[i][n] = 0;
+        }
+    }
+    s.floor = -1;
+    int center = protoLen * gridSize + protoLen;
+    vector<int> cells(protoLen);
+
+    while (true) {
+        pthread_mutex_lock(&mutex);
+        int piece = nextPiece++;
+        pthread_mutex_unlock(&mutex);
+        if (piece >= numPieces) break;
+
+        // Replaying the starting walk: residue 0 in the middle, residue 1 north of it, then the piece's moves
+        int pos = center;
+        int dir = NORTH;
+        bool turned = false;
+        s.moves = FORWARD;
+        place(s, 0, pos);
+        cells[0] = pos;
+        pos -= gridSize;
+        int score = place(s, 1, pos);
+        cells[1] = pos;
+        const unsigned char *moves = pieces.data() + (size_t) piece * splitDepth;
+        for (int i = 0; i < splitDepth; i++) {
+            if (moves[i] == LEFT) dir = (dir + 3) % 4;
+            if (moves[i] == RIGHT) dir = (dir + 1) % 4;
+            turned = turned || moves[i] != FORWARD;
+            pos += rowStep[dir] * gridSize + colStep[dir];
+            score += place(s, i + 2, pos);
+            cells[i + 2] = pos;
+            s.moves |= (uint64_t) moves[i] << (2 * (i + 1));
+        }
+
+        dfs(s, splitDepth + 2, pos, dir, turned, score);
+
+        for (int i = splitDepth + 1; i >= 0; i--) unplace(s, i, cells[i]);
+    }
+
+    // These mutex's are required for this function to be thread safe. Should not really impact performance because its only called 20 times.
+    pthread_mutex_lock(&mutex);
+    for (int i = 0; i < protoLen; i++) {
+        for (int n = 0; n <= MAXNEIGHBOURS; n++) {
+            if (s.best[i][n] > best[i][n]) {
+                best[i][n] = s.best[i][n];
+                bestMoves[i][n] = s.bestMoves[i][n];
+            }
+        }
+    }
+    pthread_mutex_unlock(&mutex);
+
+    pthread_exit(NULL);
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <prototein>" << endl;
+        return 1;
+    }
+    prototein = argv[1];
+    protoLen = strlen(argv[1]);
+    if (protoLen < 2 || protoLen > MAXLEN) {
+        cout << "This program handles protoeins from 2 to " << MAXLEN << " long" << endl;
+        return 1;
+    }
+    gridSize = (2 * protoLen) + 1;
+    buildBound();
+    for (int i = 0; i < protoLen; i++) {
+        for (int n = 0; n <= MAXNEIGHBOURS; n++) best[i][n] = -1;
+    }
+
+    pthread_mutex_init(&mutex, 0);
+    unsigned long long start = rdtsc();
+
+    // Splitting the work into starting walks, deep enough that every thread has plenty to pull from
+    vector<char> grid(gridSize * gridSize, '.');
+    int center = protoLen * gridSize + protoLen;
+    grid[center] = 'X';
+    grid[center - gridSize] = 'X';
+    splitDepth = 0;
+    numPieces = 1;
+    while (splitDepth < protoLen - 2 && numPieces < NUMTHREADS * PIECES_PER_THREAD) {
+        splitDepth++;
+        pieces.clear();
+        numPieces = 0;
+        vector<unsigned char> current;
+        collectPieces(grid, center - gridSize, NORTH, false, current);
+    }
+
+    pthread_t threads[NUMTHREADS];
+    // Creating the threads
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, parallel_func, NULL);
+    }
+
+    // Waiting for the threads to finish
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    unsigned long long stop = rdtsc();
+
+    // Every fold got filed under residue 0, so its row has the prototein's own answer
+    int maximum = -1;
+    uint64_t maxMoves = 0;
+    for (int n = 0; n <= MAXNEIGHBOURS; n++) {
+        if (best[0][n] > maximum) {
+            maximum = best[0][n];
+            maxMoves = bestMoves[0][n];
+        }
+    }
+    cout << prototein << " " << maximum << " " << movesToFold(maxMoves) << endl;
+    for (int i = 0; i < protoLen; i++) {
+        string mutant = prototein;
+        mutant[i] = (mutant[i] == 'H') ? 'P' : 'H';
+        int h;
+        int result = mutantBest(best, i, h);
+        cout << i << " " << mutant << " " << result << " " << movesToFold(bestMoves[i][h]) << endl;
+    }
+    cout << maximum << " " << stop - start << endl;
+
+    pthread_mutex_destroy(&mutex);
+}
@@ -20,6 +20,7 @@ All code is my own, optimizations were taken from "How to Avoid Yourself" by Bri
 #include <string.h>
 #include <pthread.h>
 #include <cstdint>
+#include "Prototein_Cache.h"
 using namespace std;
 
 #define FORWARD 0
@@ -31,6 +32,9 @@ using namespace std;
 #define EAST 2
 #define SOUTH 3
 
+// Stored next to every result this program puts in the cache
+#define ENGINE_NAME "Optimized_Parallel_Prototein 1"
+
 #define NUMTHREADS 20
 
 // Initializing global variables
@@ -58,6 +62,16 @@ void labelToWalk(int label,int *walk) {
     }
 }
 
+// Turns the label of a walk into forward/left/right notation for the cache
+string labelToFold(int label) {
+    string fold(protoLen - 1, 'F');
+    for (int i = protoLen - 2; i >= 0; i--) {
+        fold[i] = "FLR"[label % 3];
+        label = label / 3;
+    }
+    return fold;
+}
+
 // This could be further optimized (better/more appropriate size, probably better algorithm),
 // but I think its reaching diminishing returns (also just getting to here took me long enough).
 int score(char *prototein, int *walk) {
@@ -190,6 +204,17 @@ int main(int argc, char **argv){
     protoLen = strlen(argv[1]);
     numWalks = pow(3, protoLen-2);
 
+    // If this prototein (or its reverse) has been solved before, there is nothing to enumerate. A hit reports how long
+    // the lookup took, a miss isn't counted in the enumeration's time.
+    int cachedMaximum;
+    string cachedFold, cachedEngine;
+    unsigned long long lookupStart = rdtsc();
+    if (cacheLookup(prototein, cachedMaximum, cachedFold, cachedEngine)) {
+        unsigned long long lookupStop = rdtsc();
+        cout << cachedMaximum << " " << lookupStop - lookupStart << endl;
+        return 0;
+    }
+
     pthread_t threads[NUMTHREADS];
     pthread_mutex_init(&mutex, 0);
 
@@ -207,5 +232,7 @@ int main(int argc, char **argv){
     
     cout << maximum << " " << stop - start << endl;
 
+    cacheStore(prototein, maximum, labelToFold(maxLabel), ENGINE_NAME);
+
     pthread_mutex_destroy(&mutex);
 }
\ No newline at end of file
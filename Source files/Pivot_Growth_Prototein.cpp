@@ -0,0 +1,338 @@
+/*
+This is a program that calculates the Maximum number of H-H contacts for an n-length prototein, growing the walk out
+from the middle of the prototein instead of from residue 0. Every other version puts residue 0 in the centre and adds
+residues in order, so for something like PPPPHHHHHHPPPP the search doesn't see a single contact until it's a third of
+the way down, and a branch and bound can't cut anything that early.
+
+Here the walk starts at a pivot residue, the one with the most H's within PIVOT_WINDOW residues of it (ties go to
+whichever is nearer the middle), and grows both ends of the chain, taking turns between them until one runs out. Each
+new residue goes in a free cell next to the end it's extending. The bound on what's left works the same way as my beam
+search: when a residue gets placed it touches the residue it's attached to, plus at most 2 others (3 if it's residue 0
+or the last one, since nothing is attached after it), and only ones at the opposite parity that are already placed.
+The placement order is fixed up front, so that bound is worked out once per step.
+
+Symmetry has to be handled differently since there's no first move to pin down. The first residue placed after the
+pivot always goes north of it, which takes care of rotations. For mirror images, the first residue placed that isn't
+straight above or below the pivot has to be to its west. Every fold can be turned into exactly one fold like that (a
+fold that's a straight north-south line is its own mirror image), so each fold is still searched once.
+
+Passing "uni" uses residue 0 as the pivot and only grows one way, for comparing against the same search done the usual
+way. The starting placements are split into pieces that the 20 threads take turns pulling off a shared list, and the
+best score is shared between threads.
+
+Usage: Pivot_Growth_Prototein <prototein> [uni]
+Output: <maximum> <clock cycles>, and the fold in F/L/R notation, pivot and node count on standard error
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <cstdint>
+using namespace std;
+
+#define WEST 0
+#define NORTH 1
+#define EAST 2
+#define SOUTH 3
+
+#define NUMTHREADS 20
+#define MAXLEN 64
+
+// How far either side of a residue counts when picking the pivot
+#define PIVOT_WINDOW 2
+
+// Roughly how many starting placements each thread gets
+#define PIECES_PER_THREAD 16
+
+// Initializing global variables
+char *prototein;
+int protoLen;
+int gridSize;
+int center;
+int pivot;
+int order[MAXLEN];
+int anchor[MAXLEN];
+int bound[MAXLEN + 1];
+int splitDepth;
+vector<unsigned char> pieces;
+int numPieces;
+int nextPiece = 0;
+int maximum = -1;
+vector<int> maxCells;
+long long totalNodes = 0;
+pthread_mutex_t mutex;
+
+// Everything one thread needs. grid holds residue index + 1 in every occupied cell.
+struct Search {
+    vector<int> grid;
+    vector<int> cells;
+    long long nodes;
+};
+
+int offsets[4];
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+int pickPivot() {
+    int bestPivot = 0;
+    int bestCount = -1;
+    int bestDistance = protoLen;
+    for (int p = 0; p < protoLen; p++) {
+        int count = 0;
+        for (int i = max(0, p - PIVOT_WINDOW); i <= min(protoLen - 1, p + PIVOT_WINDOW); i++) {
+            if (prototein[i] == 'H') count++;
+        }
+        int distance = abs(2 * p - (protoLen - 1));
+        if (count > bestCount || (count == bestCount && distance < bestDistance)) {
+            bestPivot = p;
+            bestCount = count;
+            bestDistance = distance;
+        }
+    }
+    return bestPivot;
+}
+
+// The order residues get placed in, each one attached to an already placed neighbour, and the bound for every step
+void buildOrder() {
+    order[0] = pivot;
+    anchor[0] = -1;
+    int left = pivot - 1;
+    int right = pivot + 1;
+    bool goRight = true;
+    for (int t = 1; t < protoLen; t++) {
+        if (right >= protoLen) goRight = false;
+        if (left < 0) goRight = true;
+        if (goRight) {
+            order[t] = right;
+            anchor[t] = right - 1;
+            right++;
+        } else {
+            order[t] = left;
+            anchor[t] = left + 1;
+            left--;
+        }
+        goRight = !goRight;
+    }
+
+    // bound[t] is the most that steps t through protoLen - 1 can add
+    vector<bool> placed(protoLen, false);
+    placed[pivot] = true;
+    int most[MAXLEN];
+    most[0] = 0;
+    for (int t = 1; t < protoLen; t++) {
+        int r = order[t];
+        most[t] = 0;
+        if (prototein[r] == 'H') {
+            int otherParity = 0;
+            for (int i = 0; i < protoLen; i++) {
+                if (placed[i] && prototein[i] == 'H' && (r - i) % 2 != 0 && i != anchor[t]) otherParity++;
+            }
+            bool end = (r == 0 || r == protoLen - 1);
+            int touches = min(end ? 3 : 2, otherParity);
+            most[t] = 2 * (touches + (prototein[anchor[t]] == 'H'));
+        }
+        placed[r] = true;
+    }
+    bound[protoLen] = 0;
+    for (int t = protoLen - 1; t >= 0; t--) bound[t] = bound[t + 1] + most[t];
+}
+
+inline int place(Search &s, int residue, int pos) {
+    s.grid[pos] = residue + 1;
+    s.cells[residue] = pos;
+    if (prototein[residue] != 'H') return 0;
+    int gained = 0;
+    for (int d = 0; d < 4; d++) {
+        int other = s.grid[pos + offsets[d]];
+        if (other != 0 && prototein[other - 1] == 'H') gained += 2;
+    }
+    return gained;
+}
+
+// Can residue go in direction d from its anchor? offAxis is whether anything so far is off the pivot's column.
+inline int target(const Search &s, int t, int d, bool offAxis) {
+    // The first residue after the pivot goes north
+    if (t == 1 && d != NORTH) return -1;
+    int next = s.cells[anchor[t]] + offsets[d];
+    if (s.grid[next] != 0) return -1;
+    // The first residue off the pivot's column goes west
+    if (!offAxis && next % gridSize > center % gridSize) return -1;
+    return next;
+}
+
+// Steps 0 through t - 1 are placed, making score
+void dfs(Search &s, int t, bool offAxis, int score) {
+    if (t == protoLen) {
+        if (score > __atomic_load_n(&maximum, __ATOMIC_RELAXED)) {
+            pthread_mutex_lock(&mutex);
+            if (score > maximum) {
+                __atomic_store_n(&maximum, score, __ATOMIC_RELAXED);
+                maxCells = s.cells;
+            }
+            pthread_mutex_unlock(&mutex);
+        }
+        return;
+    }
+    s.nodes++;
+
+    // Another thread may have found something better, reading it without the lock is fine since it only goes up
+    if (score + bound[t] <= __atomic_load_n(&maximum, __ATOMIC_RELAXED)) return;
+
+    for (int d = 0; d < 4; d++) {
+        int next = target(s, t, d, offAxis);
+        if (next < 0) continue;
+        int gained = place(s, order[t], next);
+        dfs(s, t + 1, offAxis || next % gridSize != center % gridSize, score + gained);
+        s.grid[next] = 0;
+    }
+}
+
+void collectPieces(Search &s, int t, bool offAxis, vector<unsigned char> &current) {
+    if ((int) current.size() == splitDepth) {
+        pieces.insert(pieces.end(), current.begin(), current.end());
+        numPieces++;
+        return;
+    }
+    for (int d = 0; d < 4; d++) {
+        int next = target(s, t, d, offAxis);
+        if (next < 0) continue;
+        place(s, order[t], next);
+        current.push_back(d);
+        collectPieces(s, t + 1, offAxis || next % gridSize != center % gridSize, current);
+        current.pop_back();
+        s.grid[next] = 0;
+    }
+}
+
+void startSearch(Search &s) {
+    s.grid.assign(gridSize * gridSize, 0);
+    s.cells.assign(protoLen, -1);
+    s.nodes = 0;
+    place(s, pivot, center);
+}
+
+void *parallel_func(void *){
+    Search s;
+    startSearch(s);
+
+    while (true) {
+        pthread_mutex_lock(&mutex);
+        int piece = nextPiece++;
+        pthread_mutex_unlock(&mutex);
+        if (piece >= numPieces) break;
+
+        // Replaying the starting placements
+        const unsigned char *dirs = pieces.data() + (size_t) piece * splitDepth;
+        int score = 0;
+        bool offAxis = false;
+        for (int i = 0; i < splitDepth; i++) {
+            int t = i + 1;
+            int next = s.cells[anchor[t]] + offsets[dirs[i]];
+            score += place(s, order[t], next);
+            offAxis = offAxis || next % gridSize != center % gridSize;
+        }
+
+        dfs(s, splitDepth + 1, offAxis, score);
+
+        for (int t = 1; t <= splitDepth; t++) s.grid[s.cells[order[t]]] = 0;
+    }
+
+    pthread_mutex_lock(&mutex);
+    totalNodes += s.nodes;
+    pthread_mutex_unlock(&mutex);
+
+    pthread_exit(NULL);
+}
+
+// The fold in F/L/R notation, flipped if need be so its first turn is a left like the other programs
+string cellsToFold(const vector<int> &cells) {
+    string fold = "F";
+    bool flip = false;
+    bool turned = false;
+    for (int i = 2; i < protoLen; i++) {
+        int r1 = cells[i - 1] / gridSize - cells[i - 2] / gridSize;
+        int c1 = cells[i - 1] % gridSize - cells[i - 2] % gridSize;
+        int r2 = cells[i] / gridSize - cells[i - 1] / gridSize;
+        int c2 = cells[i] % gridSize - cells[i - 1] % gridSize;
+        // Rows go down, so turning from north to west (a left) gives a negative cross product
+        int cross = c1 * r2 - r1 * c2;
+        char m = 'F';
+        if (cross < 0) m = 'L';
+        if (cross > 0) m = 'R';
+        if (!turned && m != 'F') {
+            turned = true;
+            flip = (m == 'R');
+        }
+        if (flip && m == 'L') m = 'R';
+        else if (flip && m == 'R') m = 'L';
+        fold += m;
+    }
+    return fold;
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <prototein> [uni]" << endl;
+        return 1;
+    }
+    prototein = argv[1];
+    protoLen = strlen(argv[1]);
+    if (protoLen < 2 || protoLen > MAXLEN) {
+        cout << "This program handles protoeins from 2 to " << MAXLEN << " long" << endl;
+        return 1;
+    }
+    bool unidirectional = argc > 2 && strcmp(argv[2], "uni") == 0;
+
+    // Everything ends up within protoLen of the pivot, plus a border so neighbours never fall off
+    gridSize = (2 * protoLen) + 3;
+    center = (protoLen + 1) * gridSize + protoLen + 1;
+    offsets[WEST] = -1;
+    offsets[NORTH] = -gridSize;
+    offsets[EAST] = 1;
+    offsets[SOUTH] = gridSize;
+    pivot = unidirectional ? 0 : pickPivot();
+    buildOrder();
+
+    pthread_mutex_init(&mutex, 0);
+    unsigned long long start = rdtsc();
+
+    // Splitting the work on the first few placements, deep enough that every thread has plenty to pull from
+    Search s;
+    startSearch(s);
+    splitDepth = 0;
+    numPieces = 1;
+    while (splitDepth < protoLen - 1 && numPieces < NUMTHREADS * PIECES_PER_THREAD) {
+        splitDepth++;
+        pieces.clear();
+        numPieces = 0;
+        vector<unsigned char> current;
+        collectPieces(s, 1, false, current);
+    }
+
+    pthread_t threads[NUMTHREADS];
+    // Creating the threads
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, parallel_func, NULL);
+    }
+
+    // Waiting for the threads to finish
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    unsigned long long stop = rdtsc();
+
+    cout << maximum << " " << stop - start << endl;
+    cerr << "fold: " << cellsToFold(maxCells) << " pivot: " << pivot << " nodes: " << totalNodes << endl;
+
+    pthread_mutex_destroy(&mutex);
+}
@@ -0,0 +1,423 @@
+/*
+This is a program that calculates the Maximum number of H-H contacts for an n-length prototein, exactly, but without
+placing most of its P's one at a time. P's never make contacts, so a run of them between two H-bearing stretches only
+matters as a linker that has to fit somewhere, and the P's hanging off either end only matter as tails that have to fit
+somewhere. The other versions still try every walk through those P's, which for something like PHPPPPPPHHPHPPHP is
+most of the work.
+
+Here every run of LINKER_MIN or more P's between two other residues is a linker, and the leading and trailing P's are
+tails. The search places everything else (the core) one residue at a time like the other versions, except that after
+the residue before a linker it jumps straight to the residue after it. That residue can go in any free cell the linker
+could reach: found with a breadth first search through the free cells, it has to be at most L + 1 steps away for a run
+of L P's, and an odd or even number of steps away to match L + 1 (the lattice is a checkerboard, so every path between
+two cells has the same parity). That's a lot fewer choices than the walks through the run that would end there.
+
+Being reachable when the jump is made doesn't mean the linker will still fit once the rest of the core is placed
+around it, so the actual walks for the linkers and tails are only worked out at the end, and only for a core fold that
+would beat the best score so far. They're found by backtracking through the free cells, one segment after another, and
+if they don't all fit the core fold is thrown out. Every fold this reports really exists, and since only the core can
+score, no better fold is missed.
+
+The core is searched as a branch and bound, with the same bound on what unplaced residues can add as my beam search,
+and the best score is shared between threads. The 20 threads take turns pulling the first few core placements off a
+shared list.
+
+Only rotations are used for symmetry here, not mirror images. The first core residue is at the origin, and where the
+second core residue goes has to be straight north or somewhere in the quadrant to the north east (x >= 0, y > 0). The
+four rotations of that quadrant cover every other cell exactly once, so each fold is counted once per mirror image.
+
+Usage: Polar_Linker_Prototein <prototein>
+Output: <maximum> <clock cycles>, and the fold in F/L/R notation on standard error with some counts
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <cstdint>
+using namespace std;
+
+#define NUMTHREADS 20
+#define MAXLEN 64
+
+// Runs of this many P's or more become linkers, shorter ones are placed like any other residue
+#define LINKER_MIN 2
+
+// Roughly how many starting placements each thread gets
+#define PIECES_PER_THREAD 16
+
+// Initializing global variables
+char *prototein;
+int protoLen;
+int gridSize;
+int center;
+int firstCore;
+int lastCore;
+int nextCore[MAXLEN];
+int bound[MAXLEN + 1];
+int splitDepth;
+vector<int> pieces;
+int numPieces;
+int nextPiece = 0;
+int maximum = -1;
+vector<int> maxCells;
+long long totalLeaves = 0;
+long long totalFailed = 0;
+pthread_mutex_t mutex;
+
+// A linker between core residues from and to, or a tail walked from core residue from towards to (-1 or protoLen)
+struct Segment {
+    int from;
+    int to;
+    bool tail;
+};
+vector<Segment> segments;
+
+// Everything one thread needs. grid holds residue index + 1 in every occupied cell.
+struct Search {
+    vector<int> grid;
+    vector<int> cells;
+    vector<int> seen;
+    vector<int> queue;
+    vector<int> distance;
+    vector<vector<int> > options;
+    int stamp;
+    long long leaves;
+    long long failed;
+};
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+// bound[k] is the most that residues k through protoLen - 1 can add, worked out like Beam_Search_Prototein's
+void buildBound() {
+    bound[protoLen] = 0;
+    for (int j = protoLen - 1; j >= 0; j--) {
+        int most = 0;
+        if (prototein[j] == 'H' && j > 0) {
+            int otherParity = 0;
+            for (int i = (j % 2 == 0) ? 1 : 0; i < j - 1; i += 2) {
+                if (prototein[i] == 'H') otherParity++;
+            }
+            int touches = min(j == protoLen - 1 ? 3 : 2, otherParity);
+            most = 2 * (touches + (prototein[j - 1] == 'H'));
+        }
+        bound[j] = bound[j + 1] + most;
+    }
+}
+
+// Splitting the prototein into core residues, linkers and tails
+void buildSegments() {
+    firstCore = 0;
+    lastCore = protoLen - 1;
+    while (firstCore < protoLen && prototein[firstCore] != 'H') firstCore++;
+    if (firstCore == protoLen) {
+        // No H's at all: every fold scores 0, so the first residue is the core and the rest is one tail
+        firstCore = 0;
+        lastCore = 0;
+    } else {
+        while (prototein[lastCore] != 'H') lastCore--;
+    }
+
+    if (firstCore > 0) segments.push_back({firstCore, -1, true});
+    int k = firstCore;
+    while (k < lastCore) {
+        int run = 0;
+        while (prototein[k + 1 + run] == 'P') run++;
+        if (run >= LINKER_MIN) {
+            nextCore[k] = k + run + 1;
+            segments.push_back({k, k + run + 1, false});
+        } else {
+            nextCore[k] = k + 1;
+        }
+        k = nextCore[k];
+    }
+    if (lastCore < protoLen - 1) segments.push_back({lastCore, protoLen, true});
+}
+
+inline int rowOf(int pos) { return pos / gridSize; }
+inline int colOf(int pos) { return pos % gridSize; }
+
+inline int manhattan(int a, int b) {
+    return abs(rowOf(a) - rowOf(b)) + abs(colOf(a) - colOf(b));
+}
+
+// Cells the residue after core residue k can go in, given where k is and what's already placed
+void candidates(Search &s, int k, vector<int> &out) {
+    out.clear();
+    int pos = s.cells[k];
+    int target = nextCore[k];
+    int steps = target - k;
+    bool first = (k == firstCore);
+    const int offsets[4] = {-1, -gridSize, 1, gridSize};
+
+    if (steps == 1) {
+        for (int d = 0; d < 4; d++) {
+            // The first bond always goes north
+            if (first && offsets[d] != -gridSize) continue;
+            int next = pos + offsets[d];
+            if (s.grid[next] == 0) out.push_back(next);
+        }
+        return;
+    }
+
+    // Breadth first through the free cells, at most steps away
+    s.stamp++;
+    s.queue.clear();
+    s.queue.push_back(pos);
+    s.seen[pos] = s.stamp;
+    s.distance[pos] = 0;
+    for (size_t head = 0; head < s.queue.size(); head++) {
+        int cell = s.queue[head];
+        int dist = s.distance[cell];
+        if (dist > 0 && dist % 2 == steps % 2) {
+            // North, or north east of the first core residue
+            bool keep = true;
+            if (first) {
+                int up = rowOf(pos) - rowOf(cell);
+                int right = colOf(cell) - colOf(pos);
+                keep = right >= 0 && up > 0;
+            }
+            if (keep) out.push_back(cell);
+        }
+        if (dist == steps) continue;
+        for (int d = 0; d < 4; d++) {
+            int next = cell + offsets[d];
+            if (s.grid[next] != 0 || s.seen[next] == s.stamp) continue;
+            s.seen[next] = s.stamp;
+            s.distance[next] = dist + 1;
+            s.queue.push_back(next);
+        }
+    }
+}
+
+inline int place(Search &s, int residue, int pos) {
+    s.grid[pos] = residue + 1;
+    s.cells[residue] = pos;
+    if (prototein[residue] != 'H') return 0;
+    int gained = 0;
+    const int offsets[4] = {-1, -gridSize, 1, gridSize};
+    for (int d = 0; d < 4; d++) {
+        int other = s.grid[pos + offsets[d]];
+        if (other != 0 && prototein[other - 1] == 'H') gained += 2;
+    }
+    return gained;
+}
+
+// Walks residues of segment seg one at a time, then moves on to the next segment. True if everything fits.
+bool embed(Search &s, int seg, int residue, int pos) {
+    if (seg == (int) segments.size()) return true;
+    const Segment &g = segments[seg];
+    int step = (g.to < g.from) ? -1 : 1;
+
+    // Residue is the last one walked, at pos; the next one along the segment is residue + step
+    int next = residue + step;
+    bool done = g.tail ? (next < 0 || next >= protoLen) : (next == g.to);
+    if (done) {
+        if (seg + 1 == (int) segments.size()) return true;
+        int start = segments[seg + 1].from;
+        return embed(s, seg + 1, start, s.cells[start]);
+    }
+
+    const int offsets[4] = {-1, -gridSize, 1, gridSize};
+    for (int d = 0; d < 4; d++) {
+        int cell = pos + offsets[d];
+        if (s.grid[cell] != 0) continue;
+        // A linker has to be able to get to the residue after it in the steps it has left
+        if (!g.tail && manhattan(cell, s.cells[g.to]) > g.to - next) continue;
+        s.grid[cell] = next + 1;
+        s.cells[next] = cell;
+        bool fits = embed(s, seg, next, cell);
+        s.grid[cell] = 0;
+        if (fits) return true;
+    }
+    return false;
+}
+
+// A full core fold: if it beats the best, checking the linkers and tails fit
+void leaf(Search &s, int score) {
+    if (score <= __atomic_load_n(&maximum, __ATOMIC_RELAXED)) return;
+    s.leaves++;
+
+    bool fits = segments.empty() || embed(s, 0, segments[0].from, s.cells[segments[0].from]);
+    if (!fits) {
+        s.failed++;
+        return;
+    }
+
+    // embed takes its walks back off the grid as it returns, but cells still has them
+    pthread_mutex_lock(&mutex);
+    if (score > maximum) {
+        __atomic_store_n(&maximum, score, __ATOMIC_RELAXED);
+        maxCells = s.cells;
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+// Core residue k is placed, everything up to it has made score
+void dfs(Search &s, int k, int score) {
+    if (k == lastCore) {
+        leaf(s, score);
+        return;
+    }
+    int target = nextCore[k];
+    if (score + bound[target] <= __atomic_load_n(&maximum, __ATOMIC_RELAXED)) return;
+
+    vector<int> &options = s.options[k];
+    candidates(s, k, options);
+    for (size_t i = 0; i < options.size(); i++) {
+        int gained = place(s, target, options[i]);
+        dfs(s, target, score + gained);
+        s.grid[options[i]] = 0;
+    }
+}
+
+void collectPieces(Search &s, int k, vector<int> &current) {
+    if ((int) current.size() == splitDepth) {
+        pieces.insert(pieces.end(), current.begin(), current.end());
+        numPieces++;
+        return;
+    }
+    int target = nextCore[k];
+    vector<int> &options = s.options[k];
+    candidates(s, k, options);
+    for (size_t i = 0; i < options.size(); i++) {
+        place(s, target, options[i]);
+        current.push_back(options[i]);
+        collectPieces(s, target, current);
+        current.pop_back();
+        s.grid[options[i]] = 0;
+    }
+}
+
+void startSearch(Search &s) {
+    s.grid.assign(gridSize * gridSize, 0);
+    s.cells.assign(protoLen, -1);
+    s.seen.assign(gridSize * gridSize, 0);
+    s.distance.assign(gridSize * gridSize, 0);
+    s.options.assign(protoLen, vector<int>());
+    s.stamp = 0;
+    s.leaves = 0;
+    s.failed = 0;
+    place(s, firstCore, center);
+}
+
+void *parallel_func(void *){
+    Search s;
+    startSearch(s);
+
+    while (true) {
+        pthread_mutex_lock(&mutex);
+        int piece = nextPiece++;
+        pthread_mutex_unlock(&mutex);
+        if (piece >= numPieces) break;
+
+        // Replaying the starting placements
+        const int *cells = pieces.data() + (size_t) piece * splitDepth;
+        int k = firstCore;
+        int score = 0;
+        for (int i = 0; i < splitDepth; i++) {
+            k = nextCore[k];
+            score += place(s, k, cells[i]);
+        }
+
+        dfs(s, k, score);
+
+        for (int i = 0; i < splitDepth; i++) s.grid[cells[i]] = 0;
+    }
+
+    pthread_mutex_lock(&mutex);
+    totalLeaves += s.leaves;
+    totalFailed += s.failed;
+    pthread_mutex_unlock(&mutex);
+
+    pthread_exit(NULL);
+}
+
+// The fold in F/L/R notation, flipped if need be so its first turn is a left like the other programs
+string cellsToFold(const vector<int> &cells) {
+    string fold = "F";
+    bool flip = false;
+    bool turned = false;
+    for (int i = 2; i < protoLen; i++) {
+        int r1 = rowOf(cells[i - 1]) - rowOf(cells[i - 2]);
+        int c1 = colOf(cells[i - 1]) - colOf(cells[i - 2]);
+        int r2 = rowOf(cells[i]) - rowOf(cells[i - 1]);
+        int c2 = colOf(cells[i]) - colOf(cells[i - 1]);
+        // Cross product in row/column space: negative is a left turn (west of north is left)
+        int cross = c1 * r2 - r1 * c2;
+        char m = 'F';
+        if (cross < 0) m = 'L';
+        if (cross > 0) m = 'R';
+        if (!turned && m != 'F') {
+            turned = true;
+            flip = (m == 'R');
+        }
+        if (flip && m == 'L') m = 'R';
+        else if (flip && m == 'R') m = 'L';
+        fold += m;
+    }
+    return fold;
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <prototein>" << endl;
+        return 1;
+    }
+    prototein = argv[1];
+    protoLen = strlen(argv[1]);
+    if (protoLen < 2 || protoLen > MAXLEN) {
+        cout << "This program handles protoeins from 2 to " << MAXLEN << " long" << endl;
+        return 1;
+    }
+    // Everything ends up within protoLen of the first core residue, plus a border so neighbours never fall off
+    gridSize = (2 * protoLen) + 3;
+    center = (protoLen + 1) * gridSize + protoLen + 1;
+    buildBound();
+    buildSegments();
+
+    pthread_mutex_init(&mutex, 0);
+    unsigned long long start = rdtsc();
+
+    // Splitting the work on the first few core placements, deep enough that every thread has plenty to pull from
+    int coreSteps = 0;
+    for (int k = firstCore; k < lastCore; k = nextCore[k]) coreSteps++;
+    Search s;
+    startSearch(s);
+    splitDepth = 0;
+    numPieces = 1;
+    while (splitDepth < coreSteps && numPieces < NUMTHREADS * PIECES_PER_THREAD) {
+        splitDepth++;
+        pieces.clear();
+        numPieces = 0;
+        vector<int> current;
+        collectPieces(s, firstCore, current);
+    }
+
+    pthread_t threads[NUMTHREADS];
+    // Creating the threads
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, parallel_func, NULL);
+    }
+
+    // Waiting for the threads to finish
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    unsigned long long stop = rdtsc();
+
+    cout << maximum << " " << stop - start << endl;
+    cerr << "fold: " << cellsToFold(maxCells) << " linkers and tails: " << segments.size()
+         << " core folds checked: " << totalLeaves << " didn't fit: " << totalFailed << endl;
+
+    pthread_mutex_destroy(&mutex);
+}
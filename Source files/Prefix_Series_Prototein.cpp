@@ -0,0 +1,253 @@
+/*
+This is a program that calculates the Maximum number of H-H contacts for every prefix of a prototein (its first 4
+residues, its first 5, and so on up to the whole thing) in a single search, instead of running one of the other
+programs n - 3 times.
+
+Walks are built one residue at a time with a depth first search, so on the way to every full length walk the search
+passes through every shorter walk there is. The score of a partial walk only counts contacts between residues that
+have been placed, which is exactly the score of that prefix folded that way. So at every depth we just keep the best
+score seen at that depth and the walk that got it, and one full search gives the answer for every prefix at about the
+cost of the full length run.
+
+Like the optimized versions every walk starts by going north, and the first turn is always a left (a walk whose first
+turn is a right is the mirror image of one that turns left). That's just as true for every prefix. The work is split
+into short starting walks that the 20 threads take turns pulling off a shared list.
+
+Usage: Prefix_Series_Prototein <prototein>
+Output: one "<prefix length> <maximum> <fold>" line per prefix (fold in F/L/R notation), then "<maximum> <clock cycles>"
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string.h>
+#include <pthread.h>
+#include <cstdint>
+using namespace std;
+
+#define FORWARD 0
+#define LEFT 1
+#define RIGHT 2
+
+#define WEST 0
+#define NORTH 1
+#define EAST 2
+#define SOUTH 3
+
+#define NUMTHREADS 20
+#define MAXLEN 32
+
+// The shortest prefix that gets reported
+#define MINPREFIX 4
+
+// Roughly how many starting walks each thread gets
+#define PIECES_PER_THREAD 16
+
+// Initializing global variables
+char *prototein;
+int protoLen;
+int gridSize;
+int splitDepth;
+vector<unsigned char> pieces;
+int numPieces;
+int nextPiece = 0;
+int maximum[MAXLEN + 1];
+uint64_t maxMoves[MAXLEN + 1];
+pthread_mutex_t mutex;
+
+const int rowStep[4] = {0, -1, 0, 1};
+const int colStep[4] = {-1, 0, 1, 0};
+
+// Everything one thread needs. best[L] is the best score for the first L residues, bestMoves[L] the walk that got it.
+struct Search {
+    vector<char> grid;
+    uint64_t moves;
+    int best[MAXLEN + 1];
+    uint64_t bestMoves[MAXLEN + 1];
+};
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+string movesToFold(uint64_t moves, int length) {
+    string fold = "";
+    for (int i = 0; i < length - 1; i++) {
+        fold += "FLR"[(moves >> (2 * i)) & 3];
+    }
+    return fold;
+}
+
+int contactsAt(const Search &s, int pos) {
+    return 2 * ((s.grid[pos - 1] == 'H') + (s.grid[pos + 1] == 'H') +
+                (s.grid[pos - gridSize] == 'H') + (s.grid[pos + gridSize] == 'H'));
+}
+
+// Records a walk of the first placed residues, if it's the best one of its length so far
+inline void record(Search &s, int placed, int score) {
+    if (score > s.best[placed]) {
+        s.best[placed] = score;
+        s.bestMoves[placed] = s.moves;
+    }
+}
+
+// Places residues k through protoLen - 1, recording the score at every depth on the way down
+void dfs(Search &s, int k, int pos, int dir, bool turned, int score) {
+    record(s, k, score);
+    if (k == protoLen) return;
+
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        // Mirror images only get searched once
+        if (!turned && m == RIGHT) continue;
+
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + rowStep[d] * gridSize + colStep[d];
+        if (s.grid[next] != '.') continue;
+
+        s.grid[next] = prototein[k];
+        uint64_t saved = s.moves;
+        s.moves |= (uint64_t) m << (2 * (k - 1));
+        int gained = prototein[k] == 'H' ? contactsAt(s, next) : 0;
+        dfs(s, k + 1, next, d, turned || m != FORWARD, score + gained);
+        s.moves = saved;
+        s.grid[next] = '.';
+    }
+}
+
+void collectPieces(vector<char> &grid, int pos, int dir, bool turned, vector<unsigned char> &current) {
+    if ((int) current.size() == splitDepth) {
+        pieces.insert(pieces.end(), current.begin(), current.end());
+        numPieces++;
+        return;
+    }
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        if (!turned && m == RIGHT) continue;
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + rowStep[d] * gridSize + colStep[d];
+        if (grid[next] != '.') continue;
+        grid[next] = 'X';
+        current.push_back(m);
+        collectPieces(grid, next, d, turned || m != FORWARD, current);
+        current.pop_back();
+        grid[next] = '.';
+    }
+}
+
+void *parallel_func(void *){
+    Search s;
+    s.grid.assign(gridSize * gridSize, '.');
+    for (int i = 0; i <= protoLen; i++) {
+        s.best[i] = -1;
+        s.bestMoves[i] = 0;
+    }
+    int center = protoLen * gridSize + protoLen;
+    vector<int> cells(protoLen);
+
+    while (true) {
+        pthread_mutex_lock(&mutex);
+        int piece = nextPiece++;
+        pthread_mutex_unlock(&mutex);
+        if (piece >= numPieces) break;
+
+        // Replaying the starting walk, which also passes through the short prefixes
+        int pos = center;
+        int dir = NORTH;
+        bool turned = false;
+        s.moves = FORWARD;
+        s.grid[pos] = prototein[0];
+        cells[0] = pos;
+        record(s, 1, 0);
+        pos -= gridSize;
+        s.grid[pos] = prototein[1];
+        cells[1] = pos;
+        int score = prototein[1] == 'H' ? contactsAt(s, pos) : 0;
+        const unsigned char *moves = pieces.data() + (size_t) piece * splitDepth;
+        for (int i = 0; i < splitDepth; i++) {
+            record(s, i + 2, score);
+            if (moves[i] == LEFT) dir = (dir + 3) % 4;
+            if (moves[i] == RIGHT) dir = (dir + 1) % 4;
+            turned = turned || moves[i] != FORWARD;
+            pos += rowStep[dir] * gridSize + colStep[dir];
+            s.grid[pos] = prototein[i + 2];
+            cells[i + 2] = pos;
+            s.moves |= (uint64_t) moves[i] << (2 * (i + 1));
+            if (prototein[i + 2] == 'H') score += contactsAt(s, pos);
+        }
+
+        dfs(s, splitDepth + 2, pos, dir, turned, score);
+
+        for (int i = 0; i < splitDepth + 2; i++) s.grid[cells[i]] = '.';
+    }
+
+    // These mutex's are required for this function to be thread safe. Should not really impact performance because its only called 20 times.
+    pthread_mutex_lock(&mutex);
+    for (int i = 1; i <= protoLen; i++) {
+        if (s.best[i] > maximum[i]) {
+            maximum[i] = s.best[i];
+            maxMoves[i] = s.bestMoves[i];
+        }
+    }
+    pthread_mutex_unlock(&mutex);
+
+    pthread_exit(NULL);
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <prototein>" << endl;
+        return 1;
+    }
+    prototein = argv[1];
+    protoLen = strlen(argv[1]);
+    if (protoLen < 2 || protoLen > MAXLEN) {
+        cout << "This program handles protoeins from 2 to " << MAXLEN << " long" << endl;
+        return 1;
+    }
+    gridSize = (2 * protoLen) + 1;
+    for (int i = 0; i <= protoLen; i++) maximum[i] = -1;
+
+    pthread_mutex_init(&mutex, 0);
+    unsigned long long start = rdtsc();
+
+    // Splitting the work into starting walks, deep enough that every thread has plenty to pull from
+    vector<char> grid(gridSize * gridSize, '.');
+    int center = protoLen * gridSize + protoLen;
+    grid[center] = 'X';
+    grid[center - gridSize] = 'X';
+    splitDepth = 0;
+    numPieces = 1;
+    while (splitDepth < protoLen - 2 && numPieces < NUMTHREADS * PIECES_PER_THREAD) {
+        splitDepth++;
+        pieces.clear();
+        numPieces = 0;
+        vector<unsigned char> current;
+        collectPieces(grid, center - gridSize, NORTH, false, current);
+    }
+
+    pthread_t threads[NUMTHREADS];
+    // Creating the threads
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, parallel_func, NULL);
+    }
+
+    // Waiting for the threads to finish
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    unsigned long long stop = rdtsc();
+
+    for (int length = min(MINPREFIX, protoLen); length <= protoLen; length++) {
+        cout << length << " " << maximum[length] << " " << movesToFold(maxMoves[length], length) << endl;
+    }
+    cout << maximum[protoLen] << " " << stop - start << endl;
+
+    pthread_mutex_destroy(&mutex);
+}
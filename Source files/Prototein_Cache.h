@@ -0,0 +1,223 @@
+/*
+This is a persistent result cache for the engines, so a prototein that has already been solved once never has to be
+enumerated again. It maps a prototein to its maximum number of H-H contacts, one optimal fold, and the name and
+version of the engine that found it.
+
+Only Optimized_Sequential_Prototein and Optimized_Parallel_Prototein use it so far. The other exact engines have their
+own run modes (prefixes, constraints, energy matrices, approximate answers) that a prototein alone doesn't describe, so
+their answers can't safely share a key with these. Any engine whose answer depends only on the prototein can use it
+by calling cacheLookup() before searching and cacheStore() after, with its own ENGINE_NAME.
+
+A prototein and its reverse have the same maximum (walking the same fold from the other end gives the same contacts),
+so both are stored under one key: whichever of the two comes first alphabetically. The fold is stored for the key, and
+is flipped around on the way out if the caller asked for the reverse.
+
+The cache is a fixed-size hash table in a file that every process maps into memory with mmap. Readers never lock.
+A writer takes an flock on the file, fills in an empty slot, and only then marks the slot as used, so a reader either
+sees a complete entry or an empty slot. Entries are never changed once written, which is what makes the lock-free
+reads safe. Once all CACHE_SLOTS slots are used nothing more gets stored, and the first store that doesn't fit prints
+a warning on standard error. The cache is off unless PROTOTEIN_CACHE is set to the path of the file to use, so timing runs keep
+measuring the enumeration unless they ask for the cache.
+
+Folds are written in forward/left/right notation, one letter per move, starting with the first move (always F).
+
+mmap and flock are POSIX only, so on Windows every lookup misses and nothing is stored.
+
+@author: Owen Sheed
+*/
+#ifndef PROTOTEIN_CACHE_H
+#define PROTOTEIN_CACHE_H
+
+#include <string>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#endif
+
+#define CACHE_VERSION 1
+#define CACHE_SLOTS 65536
+#define CACHE_KEYLEN 64
+#define CACHE_ENGINELEN 40
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slots;
+};
+
+struct CacheEntry {
+    uint32_t used;
+    int32_t maximum;
+    char key[CACHE_KEYLEN];
+    char fold[CACHE_KEYLEN];
+    char engine[CACHE_ENGINELEN];
+};
+
+// Whichever of the prototein and its reverse comes first alphabetically
+inline std::string canonicalPrototein(const std::string &prototein) {
+    std::string reversed(prototein.rbegin(), prototein.rend());
+    return reversed < prototein ? reversed : prototein;
+}
+
+// Walking a fold from the other end reverses the order of the turns and swaps left with right.
+// The first move stays forward because every fold starts by going north.
+inline std::string reverseFold(const std::string &fold) {
+    std::string reversed = "F";
+    for (int i = (int) fold.size() - 1; i >= 1; i--) {
+        if (fold[i] == 'L') reversed += 'R';
+        else if (fold[i] == 'R') reversed += 'L';
+        else reversed += 'F';
+    }
+    return reversed;
+}
+
+#ifndef _WIN32
+
+inline uint32_t cacheHash(const std::string &key) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < key.size(); i++) {
+        h ^= (unsigned char) key[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Maps the cache file, creating and sizing it the first time. Returns NULL if the cache is off or unusable.
+// The mapping is kept for the life of the process.
+inline CacheHeader *cacheMap(int &fd) {
+    static CacheHeader *header = NULL;
+    static int fileDescriptor = -1;
+    static bool tried = false;
+
+    if (tried) {
+        fd = fileDescriptor;
+        return header;
+    }
+    tried = true;
+
+    const char *path = getenv("PROTOTEIN_CACHE");
+    if (path == NULL || path[0] == '\0') return NULL;
+
+    int f = open(path, O_RDWR | O_CREAT, 0666);
+    if (f < 0) return NULL;
+
+    size_t size = sizeof(CacheHeader) + (size_t) CACHE_SLOTS * sizeof(CacheEntry);
+
+    // Only one process gets to create the file, everybody else waits for it to be ready
+    flock(f, LOCK_EX);
+    struct stat info;
+    if (fstat(f, &info) != 0 || ((size_t) info.st_size < size && ftruncate(f, size) != 0)) {
+        flock(f, LOCK_UN);
+        close(f);
+        return NULL;
+    }
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, f, 0);
+    if (memory == MAP_FAILED) {
+        flock(f, LOCK_UN);
+        close(f);
+        return NULL;
+    }
+    CacheHeader *h = (CacheHeader *) memory;
+    if (h->magic[0] == '\0') {
+        memcpy(h->magic, "PROTOCH", 8);
+        h->version = CACHE_VERSION;
+        h->slots = CACHE_SLOTS;
+    }
+    flock(f, LOCK_UN);
+
+    // A file from a different cache layout is left alone
+    if (memcmp(h->magic, "PROTOCH", 8) != 0 || h->version != CACHE_VERSION || h->slots != CACHE_SLOTS) {
+        munmap(memory, size);
+        close(f);
+        return NULL;
+    }
+
+    header = h;
+    fileDescriptor = f;
+    fd = f;
+    return header;
+}
+
+// Looks the prototein up. On a hit fills in the maximum, an optimal fold for this prototein (not the canonical one),
+// and the engine that computed it.
+inline bool cacheLookup(const char *prototein, int &maximum, std::string &fold, std::string &engine) {
+    std::string query = prototein;
+    std::string key = canonicalPrototein(query);
+    if (key.size() >= CACHE_KEYLEN) return false;
+
+    int fd;
+    CacheHeader *header = cacheMap(fd);
+    if (header == NULL) return false;
+    CacheEntry *slots = (CacheEntry *) (header + 1);
+
+    uint32_t slot = cacheHash(key) % CACHE_SLOTS;
+    for (int probe = 0; probe < CACHE_SLOTS; probe++) {
+        CacheEntry *entry = &slots[(slot + probe) % CACHE_SLOTS];
+        if (__atomic_load_n(&entry->used, __ATOMIC_ACQUIRE) == 0) return false;
+        if (strcmp(entry->key, key.c_str()) == 0) {
+            maximum = entry->maximum;
+            fold = entry->fold;
+            engine = entry->engine;
+            if (key != query) fold = reverseFold(fold);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Stores a result. The fold is for the prototein as given. Does nothing if the prototein is already cached.
+inline void cacheStore(const char *prototein, int maximum, const std::string &fold, const char *engine) {
+    std::string query = prototein;
+    std::string key = canonicalPrototein(query);
+    if (key.size() >= CACHE_KEYLEN || fold.size() >= CACHE_KEYLEN) return;
+
+    int fd;
+    CacheHeader *header = cacheMap(fd);
+    if (header == NULL) return;
+    CacheEntry *slots = (CacheEntry *) (header + 1);
+
+    std::string canonicalFold = (key == query) ? fold : reverseFold(fold);
+
+    flock(fd, LOCK_EX);
+    uint32_t slot = cacheHash(key) % CACHE_SLOTS;
+    bool stored = false;
+    for (int probe = 0; probe < CACHE_SLOTS && !stored; probe++) {
+        CacheEntry *entry = &slots[(slot + probe) % CACHE_SLOTS];
+        if (entry->used && strcmp(entry->key, key.c_str()) == 0) stored = true;
+        else if (!entry->used) {
+            entry->maximum = maximum;
+            strncpy(entry->key, key.c_str(), CACHE_KEYLEN - 1);
+            strncpy(entry->fold, canonicalFold.c_str(), CACHE_KEYLEN - 1);
+            strncpy(entry->engine, engine, CACHE_ENGINELEN - 1);
+            // Publishing the slot last is what lets readers skip the lock
+            __atomic_store_n(&entry->used, 1, __ATOMIC_RELEASE);
+            stored = true;
+        }
+    }
+    flock(fd, LOCK_UN);
+
+    // Every slot is taken, the result just doesn't get kept
+    static bool warned = false;
+    if (!stored && !warned) {
+        warned = true;
+        fprintf(stderr, "prototein cache is full (%d entries), new results are not being stored\n", CACHE_SLOTS);
+    }
+}
+
+#else
+
+inline bool cacheLookup(const char *, int &, std::string &, std::string &) { return false; }
+inline void cacheStore(const char *, int, const std::string &, const char *) {}
+
+#endif
+
+#endif
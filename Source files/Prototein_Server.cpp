@@ -0,0 +1,533 @@
+/*
+This is a long running version of the prototein solver. Instead of starting a new process (and 20 new threads) for
+every prototein, like RuntimeAnalysisWrapper.py does, it starts its threads once and then answers requests that come
+in over a Unix domain socket. The threads, their grids, and the way each length gets split into work stay around
+between requests, so a request only pays for the search itself.
+
+Walks are built one residue at a time with a depth first search instead of generating every label and scoring it from
+scratch, so a walk that runs into itself is dropped along with everything that would have grown from it. Like the
+optimized versions every walk starts by going north, and on top of that the first turn is always a left, because a
+walk whose first turn is a right is just the mirror image of one that turns left (same contacts).
+
+Each length is cut into a few hundred work pieces, one per short starting walk. That list is worked out the first time
+a length is asked for and kept. Workers hand out pieces round robin across all requests that are currently running,
+so a big request can't starve a small one that came in behind it.
+
+Protocol, one request per line:
+    FOLD <prototein> [timeout in ms]  ->  OK <maximum> <fold> <microseconds> | TIMEOUT | ERROR <reason>
+    STATS                             ->  one "<length> <count> <p50 us> <p99 us>" line per length, then END
+    SHUTDOWN                          ->  BYE, and the server exits
+The fold is written in forward/left/right notation. A client that hangs up or sends CANCEL while its request is
+running cancels it, and the workers drop the rest of its pieces.
+
+Usage: Prototein_Server [socket path] [number of threads]
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+using namespace std;
+
+#define FORWARD 0
+#define LEFT 1
+#define RIGHT 2
+
+#define WEST 0
+#define NORTH 1
+#define EAST 2
+#define SOUTH 3
+
+#define NUMTHREADS 20
+#define MAXLEN 64
+
+// Roughly how many work pieces each length gets split into
+#define PIECES_PER_THREAD 16
+
+// How often (in placed residues) a worker checks whether its request was cancelled
+#define CANCEL_CHECK 4096
+
+// The short starting walks a length is split into. Each piece is splitDepth moves long, after the fixed first move.
+struct Split {
+    int splitDepth;
+    vector<unsigned char> moves;
+    int pieces;
+};
+
+struct Job {
+    string prototein;
+    int protoLen;
+    Split *split;
+    int nextPiece;
+    int donePieces;
+    bool cancelled;
+    int maximum;
+    string fold;
+    pthread_mutex_t mutex;
+    pthread_cond_t finished;
+};
+
+// Initializing global variables
+int numThreads = NUMTHREADS;
+// Cleared by SHUTDOWN on a connection thread and read everywhere, so every access goes through __atomic builtins
+bool running = true;
+int listenFd = -1;
+map<int, Split *> splits;
+vector<Job *> activeJobs;
+size_t roundRobin = 0;
+map<int, vector<double> > latencies;
+pthread_mutex_t queueMutex;
+pthread_cond_t workReady;
+pthread_mutex_t splitMutex;
+pthread_mutex_t statsMutex;
+
+// Everything one worker needs to search a piece. Kept per worker so the grid is only allocated once.
+struct Search {
+    const char *prototein;
+    int protoLen;
+    int size;
+    vector<unsigned char> grid;
+    int moves[MAXLEN];
+    int best;
+    int bestMoves[MAXLEN];
+    Job *job;
+    long long nodes;
+    bool stop;
+};
+
+const int rowStep[4] = {0, -1, 0, 1};
+const int colStep[4] = {-1, 0, 1, 0};
+
+// Number of H neighbours of a cell, each one is worth 2 because the original scoring counts every contact from both ends
+int contactsAt(Search &s, int pos) {
+    int h = 0;
+    h += s.grid[pos - 1] == 'H';
+    h += s.grid[pos + 1] == 'H';
+    h += s.grid[pos - s.size] == 'H';
+    h += s.grid[pos + s.size] == 'H';
+    return 2 * h;
+}
+
+// Places residues k through protoLen - 1. pos and dir are where residue k - 1 sits and which way it was heading.
+void dfs(Search &s, int k, int pos, int dir, bool turned, int score) {
+    if (s.stop) return;
+    if (k == s.protoLen) {
+        if (score > s.best) {
+            s.best = score;
+            memcpy(s.bestMoves, s.moves, sizeof(int) * s.protoLen);
+        }
+        return;
+    }
+    if (++s.nodes % CANCEL_CHECK == 0) {
+        pthread_mutex_lock(&s.job->mutex);
+        s.stop = s.job->cancelled;
+        pthread_mutex_unlock(&s.job->mutex);
+        if (s.stop) return;
+    }
+
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        // Mirror images only get searched once
+        if (!turned && m == RIGHT) continue;
+
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + rowStep[d] * s.size + colStep[d];
+        if (s.grid[next] != '.') continue;
+
+        s.grid[next] = s.prototein[k];
+        s.moves[k - 1] = m;
+        int gained = s.prototein[k] == 'H' ? contactsAt(s, next) : 0;
+        dfs(s, k + 1, next, d, turned || m != FORWARD, score + gained);
+        s.grid[next] = '.';
+    }
+}
+
+// Collects every self avoiding starting walk of the given number of moves, walking the same tree dfs() does
+void collectPieces(vector<unsigned char> &grid, int size, int depth, int pos, int dir, bool turned,
+                   vector<unsigned char> &current, Split *split) {
+    if ((int) current.size() == depth) {
+        split->moves.insert(split->moves.end(), current.begin(), current.end());
+        split->pieces++;
+        return;
+    }
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        if (!turned && m == RIGHT) continue;
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + rowStep[d] * size + colStep[d];
+        if (grid[next] != '.') continue;
+        grid[next] = 'X';
+        current.push_back(m);
+        collectPieces(grid, size, depth, next, d, turned || m != FORWARD, current, split);
+        current.pop_back();
+        grid[next] = '.';
+    }
+}
+
+// Returns how a length is split into pieces, working it out the first time
+Split *getSplit(int protoLen) {
+    pthread_mutex_lock(&splitMutex);
+    Split *split = splits[protoLen];
+    if (split == NULL) {
+        split = new Split();
+        int size = (2 * protoLen) + 1;
+        vector<unsigned char> grid(size * size, '.');
+        int center = protoLen * size + protoLen;
+        grid[center] = 'X';
+        grid[center - size] = 'X';
+
+        // Deep enough for every thread to get plenty of pieces, but never past the end of the prototein
+        split->splitDepth = 0;
+        split->pieces = 1;
+        while (split->splitDepth < protoLen - 2 && split->pieces < numThreads * PIECES_PER_THREAD) {
+            split->splitDepth++;
+            split->moves.clear();
+            split->pieces = 0;
+            vector<unsigned char> current;
+            collectPieces(grid, size, split->splitDepth, center - size, NORTH, false, current, split);
+        }
+        splits[protoLen] = split;
+    }
+    pthread_mutex_unlock(&splitMutex);
+    return split;
+}
+
+// Searches one piece of a request: replays the piece's starting moves and runs dfs() from the end of them
+void runPiece(Search &s, Job *job, int piece) {
+    int n = job->protoLen;
+    if (s.protoLen != n) {
+        s.size = (2 * n) + 1;
+        s.grid.assign(s.size * s.size, '.');
+    }
+    s.prototein = job->prototein.c_str();
+    s.protoLen = n;
+    s.best = -1;
+    s.job = job;
+    s.nodes = 0;
+    s.stop = false;
+
+    int center = n * s.size + n;
+    int pos = center;
+    int dir = NORTH;
+    bool turned = false;
+    int score = 0;
+    vector<int> path;
+
+    s.grid[pos] = s.prototein[0];
+    path.push_back(pos);
+    if (n > 1) {
+        pos -= s.size;
+        s.grid[pos] = s.prototein[1];
+        path.push_back(pos);
+        s.moves[0] = FORWARD;
+        if (s.prototein[1] == 'H') score += contactsAt(s, pos);
+    }
+
+    Split *split = job->split;
+    const unsigned char *start = split->moves.data() + (size_t) piece * split->splitDepth;
+    for (int i = 0; i < split->splitDepth; i++) {
+        int m = start[i];
+        if (m == LEFT) dir = (dir + 3) % 4;
+        if (m == RIGHT) dir = (dir + 1) % 4;
+        turned = turned || m != FORWARD;
+        pos += rowStep[dir] * s.size + colStep[dir];
+        s.grid[pos] = s.prototein[i + 2];
+        s.moves[i + 1] = m;
+        if (s.prototein[i + 2] == 'H') score += contactsAt(s, pos);
+        path.push_back(pos);
+    }
+
+    dfs(s, (int) path.size(), pos, dir, turned, score);
+
+    // Handing the grid back empty for the next piece
+    for (size_t i = 0; i < path.size(); i++) s.grid[path[i]] = '.';
+}
+
+void *worker_func(void *) {
+    Search s;
+    s.protoLen = 0;
+
+    while (true) {
+        pthread_mutex_lock(&queueMutex);
+        while (__atomic_load_n(&running, __ATOMIC_ACQUIRE) && activeJobs.empty()) {
+            pthread_cond_wait(&workReady, &queueMutex);
+        }
+        if (!__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+            pthread_mutex_unlock(&queueMutex);
+            break;
+        }
+
+        // Round robin across the requests that still have pieces left
+        roundRobin = roundRobin % activeJobs.size();
+        Job *job = activeJobs[roundRobin];
+        int piece = job->nextPiece++;
+        if (job->nextPiece == job->split->pieces) {
+            activeJobs.erase(activeJobs.begin() + roundRobin);
+        } else {
+            roundRobin++;
+        }
+        pthread_mutex_unlock(&queueMutex);
+
+        pthread_mutex_lock(&job->mutex);
+        bool cancelled = job->cancelled;
+        pthread_mutex_unlock(&job->mutex);
+
+        if (!cancelled) runPiece(s, job, piece);
+
+        pthread_mutex_lock(&job->mutex);
+        if (!cancelled && !s.stop && s.best > job->maximum) {
+            job->maximum = s.best;
+            job->fold = "";
+            for (int i = 0; i < job->protoLen - 1; i++) job->fold += "FLR"[s.bestMoves[i]];
+        }
+        job->donePieces++;
+        if (job->donePieces == job->split->pieces) pthread_cond_signal(&job->finished);
+        pthread_mutex_unlock(&job->mutex);
+    }
+    return NULL;
+}
+
+// Takes a job's unstarted pieces off the queue. Pieces already running notice the flag on their own.
+void cancelJob(Job *job) {
+    pthread_mutex_lock(&queueMutex);
+    pthread_mutex_lock(&job->mutex);
+    job->cancelled = true;
+    vector<Job *>::iterator it = find(activeJobs.begin(), activeJobs.end(), job);
+    if (it != activeJobs.end()) {
+        activeJobs.erase(it);
+        job->donePieces += job->split->pieces - job->nextPiece;
+        job->nextPiece = job->split->pieces;
+        if (job->donePieces == job->split->pieces) pthread_cond_signal(&job->finished);
+    }
+    pthread_mutex_unlock(&job->mutex);
+    pthread_mutex_unlock(&queueMutex);
+}
+
+double percentile(vector<double> values, double p) {
+    sort(values.begin(), values.end());
+    size_t index = (size_t) (p * (values.size() - 1) + 0.5);
+    return values[index];
+}
+
+string statsReport() {
+    string report;
+    pthread_mutex_lock(&statsMutex);
+    for (map<int, vector<double> >::iterator it = latencies.begin(); it != latencies.end(); it++) {
+        report += to_string(it->first) + " " + to_string(it->second.size()) + " " +
+                  to_string((long long) percentile(it->second, 0.50)) + " " +
+                  to_string((long long) percentile(it->second, 0.99)) + "\n";
+    }
+    pthread_mutex_unlock(&statsMutex);
+    return report + "END\n";
+}
+
+void sendLine(int fd, const string &line) {
+    size_t sent = 0;
+    while (sent < line.size()) {
+        ssize_t n = send(fd, line.c_str() + sent, line.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        sent += n;
+    }
+}
+
+// Runs one FOLD request to completion, timeout, or cancellation. Returns the reply, or "" if the client went away.
+string solve(int fd, const string &prototein, long timeoutMs, string &pending) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int n = prototein.size();
+
+    if (n == 0 || n > MAXLEN) return "ERROR length must be between 1 and " + to_string(MAXLEN) + "\n";
+    for (int i = 0; i < n; i++) {
+        if (prototein[i] != 'H' && prototein[i] != 'P') return "ERROR prototein can only contain H and P\n";
+    }
+
+    Job *job = new Job();
+    job->prototein = prototein;
+    job->protoLen = n;
+    job->split = getSplit(n);
+    job->nextPiece = 0;
+    job->donePieces = 0;
+    job->cancelled = false;
+    job->maximum = -1;
+    pthread_mutex_init(&job->mutex, 0);
+    pthread_cond_init(&job->finished, 0);
+
+    pthread_mutex_lock(&queueMutex);
+    activeJobs.push_back(job);
+    pthread_cond_broadcast(&workReady);
+    pthread_mutex_unlock(&queueMutex);
+
+    // Waiting in short slices so the deadline and the client's socket both get checked. The wait wakes up as soon
+    // as the last piece finishes, so small requests don't pay for the slice.
+    bool timedOut = false;
+    bool clientGone = false;
+    while (true) {
+        pthread_mutex_lock(&job->mutex);
+        if (job->donePieces != job->split->pieces) {
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += 5000000;
+            if (until.tv_nsec >= 1000000000) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&job->finished, &job->mutex, &until);
+        }
+        bool done = job->donePieces == job->split->pieces;
+        bool cancelled = job->cancelled;
+        pthread_mutex_unlock(&job->mutex);
+        if (done) break;
+        if (cancelled) continue;
+
+        long elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+        if (timeoutMs > 0 && elapsed >= timeoutMs) {
+            timedOut = true;
+            cancelJob(job);
+            continue;
+        }
+
+        struct pollfd p = {fd, POLLIN, 0};
+        if (poll(&p, 1, 0) > 0) {
+            char buffer[256];
+            ssize_t got = recv(fd, buffer, sizeof(buffer), 0);
+            if (got <= 0) {
+                clientGone = true;
+                cancelJob(job);
+            } else {
+                pending.append(buffer, got);
+                if (pending.find("CANCEL") != string::npos) {
+                    pending.clear();
+                    cancelJob(job);
+                }
+            }
+        }
+    }
+
+    bool cancelled = job->cancelled;
+    string reply;
+    if (!cancelled) {
+        double micros = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+        pthread_mutex_lock(&statsMutex);
+        latencies[n].push_back(micros);
+        pthread_mutex_unlock(&statsMutex);
+
+        // A single residue has no moves, so there is nothing to print for the fold
+        string fold = job->fold.empty() ? "-" : job->fold;
+        reply = "OK " + to_string(job->maximum) + " " + fold + " " + to_string((long long) micros) + "\n";
+    } else if (timedOut) {
+        reply = "TIMEOUT\n";
+    } else if (!clientGone) {
+        reply = "CANCELLED\n";
+    }
+
+    pthread_mutex_destroy(&job->mutex);
+    pthread_cond_destroy(&job->finished);
+    delete job;
+    return reply;
+}
+
+void *connection_func(void *arg) {
+    int fd = (int) (intptr_t) arg;
+    string pending;
+    char buffer[1024];
+
+    while (__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+        size_t newline = pending.find('\n');
+        if (newline == string::npos) {
+            ssize_t got = recv(fd, buffer, sizeof(buffer), 0);
+            if (got <= 0) break;
+            pending.append(buffer, got);
+            continue;
+        }
+        string line = pending.substr(0, newline);
+        pending.erase(0, newline + 1);
+        if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+
+        char command[16] = "";
+        char prototein[MAXLEN + 2] = "";
+        long timeoutMs = 0;
+        sscanf(line.c_str(), "%15s %65s %ld", command, prototein, &timeoutMs);
+
+        if (strcmp(command, "FOLD") == 0) {
+            string reply = solve(fd, prototein, timeoutMs, pending);
+            if (reply.empty()) break;
+            sendLine(fd, reply);
+        } else if (strcmp(command, "STATS") == 0) {
+            sendLine(fd, statsReport());
+        } else if (strcmp(command, "SHUTDOWN") == 0) {
+            sendLine(fd, "BYE\n");
+            __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+            shutdown(listenFd, SHUT_RDWR);
+            break;
+        } else if (strcmp(command, "CANCEL") != 0 && command[0] != '\0') {
+            sendLine(fd, "ERROR unknown command\n");
+        }
+    }
+
+    close(fd);
+    return NULL;
+}
+
+int main(int argc, char **argv){
+    const char *socketPath = argc > 1 ? argv[1] : "/tmp/prototein.sock";
+    if (argc > 2) numThreads = max(1, atoi(argv[2]));
+
+    signal(SIGPIPE, SIG_IGN);
+    pthread_mutex_init(&queueMutex, 0);
+    pthread_cond_init(&workReady, 0);
+    pthread_mutex_init(&splitMutex, 0);
+    pthread_mutex_init(&statsMutex, 0);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+    unlink(socketPath);
+    if (listenFd < 0 || bind(listenFd, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(listenFd, 64) != 0) {
+        cout << "Could not listen on " << socketPath << endl;
+        return 1;
+    }
+
+    // The warm pool. These threads live as long as the server does.
+    vector<pthread_t> threads(numThreads);
+    for (int t = 0; t < numThreads; t++) {
+        pthread_create(&threads[t], NULL, worker_func, NULL);
+    }
+
+    cout << "Listening on " << socketPath << " with " << numThreads << " threads" << endl;
+
+    while (__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+        int fd = accept(listenFd, NULL, NULL);
+        if (fd < 0) break;
+        pthread_t connection;
+        pthread_create(&connection, NULL, connection_func, (void *) (intptr_t) fd);
+        pthread_detach(connection);
+    }
+
+    pthread_mutex_lock(&queueMutex);
+    __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&workReady);
+    pthread_mutex_unlock(&queueMutex);
+    for (int t = 0; t < numThreads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    // Final latency report: length, number of requests, p50 and p99 in microseconds
+    cout << statsReport();
+
+    close(listenFd);
+    unlink(socketPath);
+}
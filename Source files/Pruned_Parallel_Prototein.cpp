@@ -0,0 +1,367 @@
+/*
+This is a program that calculates the Maximum number of H-H contacts for an n-length prototein, building walks one
+residue at a time (depth first) and cutting off walks that have trapped themselves.
+
+A walk can wall its own head into a pocket that is too small to hold the rest of the prototein. Nothing that grows out
+of that walk can ever finish, but a plain search only finds out at the very end, after trying every way of filling
+the pocket. Here the grid is a bitboard (one 64 bit row per lattice row), and when the head could have just sealed off
+a pocket, every move it can make gets a flood fill outward from the cell it moves into, counting the free cells it can
+still reach. If there aren't enough for the remaining residues, that move is skipped along with everything under it.
+The lattice is a checkerboard and the walk alternates colours, so it's not just the number of free cells that has to
+be big enough but the number of each colour.
+
+Two things keep the check cheap. First, it only runs when the head could actually have split the free space, meaning
+its 8 surrounding cells contain more than one separate run of occupied cells (looked up in a table from the 3x3 block
+around it). If they don't, the free cells around the head are all still connected, and the next move leaves exactly
+as much room as there was before, so there's nothing new to find. When they do, the moves can lead into different
+pieces, which is why the fill starts from each move's cell and not from the head. Second, the flood fill works on whole
+rows at a time and stops as soon as it has found enough cells of both colours, so in open space it stops almost
+straight away.
+
+Don't expect much from it on the proteins in the tests though. Pockets that trap the head are small, and so is the
+part of the tree inside them: from 18 to 22 long it cuts a little under 1% of the nodes (0.79% at 18, 0.87% at 22),
+which doesn't make up for what the fills cost. So pruning is off unless it's asked for, and without it this is a
+plain bitboard depth first search.
+
+Like the optimized versions every walk starts by going north, and the first turn is always a left (a walk whose first
+turn is a right is the mirror image of one that turns left). Work is split into short starting walks that the 20 threads
+take turns pulling off a shared list.
+
+The maximum and run time go to standard output like the other programs. The number of search nodes, room checks, and
+subtrees cut off go to standard error. Passing "prune" as the second argument turns pruning on.
+
+Usage: Pruned_Parallel_Prototein <prototein> [prune]
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <vector>
+#include <string.h>
+#include <pthread.h>
+#include <cstdint>
+using namespace std;
+
+#define FORWARD 0
+#define LEFT 1
+#define RIGHT 2
+
+#define WEST 0
+#define NORTH 1
+#define EAST 2
+#define SOUTH 3
+
+#define NUMTHREADS 20
+
+// The grid is 2n + 1 cells across and each row has to fit in 64 bits
+#define MAXLEN 31
+
+// With this many residues or fewer left after a move, finding the dead end the slow way is as cheap as the check
+#define MIN_REMAINING 1
+
+// Roughly how many starting walks each thread gets
+#define PIECES_PER_THREAD 16
+
+// Initializing global variables
+char *prototein;
+int protoLen;
+int gridSize;
+bool pruning = false;
+int splitDepth;
+vector<unsigned char> pieces;
+int numPieces;
+int nextPiece = 0;
+int maximum = -1;
+long long totalNodes = 0;
+long long totalChecks = 0;
+long long totalPruned = 0;
+pthread_mutex_t mutex;
+
+const int rowStep[4] = {0, -1, 0, 1};
+const int colStep[4] = {-1, 0, 1, 0};
+
+// Everything one thread needs for its search
+struct Search {
+    uint64_t occupied[2 * MAXLEN + 3];
+    uint64_t hydrophobic[2 * MAXLEN + 3];
+    uint64_t reach[2 * MAXLEN + 3];
+    int best;
+    long long nodes;
+    long long checks;
+    long long pruned;
+};
+
+// The even columns. On an even row those are the cells of colour 0, on an odd row the odd columns are.
+uint64_t evenColour;
+uint64_t rowMask;
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+inline bool isSet(const uint64_t *board, int r, int c) {
+    return (board[r] >> c) & 1;
+}
+
+// Whether the head can have cut the free cells around it in two, for every pattern of occupied cells in the 3x3 block
+// around it (bit 3 * row + column, the head in the middle). That's when the 8 surrounding cells, going round in order,
+// contain more than one separate run of occupied cells. With one run or less the free cells around the head are all
+// still connected to each other.
+bool splits[512];
+
+void buildSplits() {
+    const int ring[8] = {1, 2, 5, 8, 7, 6, 3, 0};
+    for (int pattern = 0; pattern < 512; pattern++) {
+        int runs = 0;
+        bool previous = (pattern >> ring[7]) & 1;
+        for (int i = 0; i < 8; i++) {
+            bool current = (pattern >> ring[i]) & 1;
+            if (current && !previous) runs++;
+            previous = current;
+        }
+        splits[pattern] = runs > 1;
+    }
+}
+
+// The 3x3 block of occupied cells around (r, c), three bits from each row
+inline int neighbourhood(const Search &s, int r, int c) {
+    return ((s.occupied[r - 1] >> (c - 1)) & 7) | (((s.occupied[r] >> (c - 1)) & 7) << 3) |
+           (((s.occupied[r + 1] >> (c - 1)) & 7) << 6);
+}
+
+// Flood fills the free cells reachable from the head at (r, c), a row at a time, until it has found enough of each
+// colour for the remaining residues. Returns false if it runs out of cells first, meaning the head is trapped.
+bool enoughRoom(Search &s, int r, int c, int remaining) {
+    // The residue after the head is the other colour, so the other colour needs the extra cell if remaining is odd
+    int headColour = (r + c) & 1;
+    int needOther = (remaining + 1) / 2;
+    int needSame = remaining / 2;
+
+    int top = r;
+    int bottom = r;
+    s.reach[r] = 1ull << c;
+    while (true) {
+        bool changed = false;
+        if (top > 0) s.reach[--top] = 0;
+        if (bottom < gridSize - 1) s.reach[++bottom] = 0;
+
+        int same = 0;
+        int other = 0;
+        // Sweeping down then up lets a new cell spread through a whole column or row in one pass.
+        // The colours get counted on the way back up.
+        for (int row = top; row <= bottom; row++) {
+            uint64_t grown = s.reach[row] | (s.reach[row] << 1) | (s.reach[row] >> 1);
+            if (row > top) grown |= s.reach[row - 1];
+            if (row < bottom) grown |= s.reach[row + 1];
+            grown &= ~s.occupied[row] & rowMask;
+            if (row == r) grown |= 1ull << c;
+            changed |= grown != s.reach[row];
+            s.reach[row] = grown;
+        }
+        for (int row = bottom; row >= top; row--) {
+            uint64_t grown = s.reach[row] | (s.reach[row] << 1) | (s.reach[row] >> 1);
+            if (row > top) grown |= s.reach[row - 1];
+            if (row < bottom) grown |= s.reach[row + 1];
+            grown &= ~s.occupied[row] & rowMask;
+            if (row == r) grown |= 1ull << c;
+            changed |= grown != s.reach[row];
+            s.reach[row] = grown;
+
+            uint64_t free = (row == r) ? grown & ~(1ull << c) : grown;
+            uint64_t colourZero = (row & 1) ? ~evenColour : evenColour;
+            int zero = __builtin_popcountll(free & colourZero);
+            int one = __builtin_popcountll(free) - zero;
+            same += headColour == 0 ? zero : one;
+            other += headColour == 0 ? one : zero;
+        }
+        if (same >= needSame && other >= needOther) return true;
+        if (!changed) return false;
+    }
+}
+
+// Places residues k through protoLen - 1. (r, c) is where residue k - 1 is and dir is the way it was heading.
+void dfs(Search &s, int k, int r, int c, int dir, bool turned, int score) {
+    if (k == protoLen) {
+        if (score > s.best) s.best = score;
+        return;
+    }
+    s.nodes++;
+
+    // The head may have just cut the free cells around it in two, in which case each move goes into one of the pieces
+    // and has to be checked on its own. Checking from the head would count both pieces together.
+    bool split = pruning && protoLen - k > MIN_REMAINING && splits[neighbourhood(s, r, c)];
+
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        // Mirror images only get searched once
+        if (!turned && m == RIGHT) continue;
+
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int nr = r + rowStep[d];
+        int nc = c + colStep[d];
+        if (isSet(s.occupied, nr, nc)) continue;
+
+        if (split) {
+            s.checks++;
+            if (!enoughRoom(s, nr, nc, protoLen - k - 1)) {
+                s.pruned++;
+                continue;
+            }
+        }
+
+        int gained = 0;
+        if (prototein[k] == 'H') {
+            gained = 2 * (isSet(s.hydrophobic, nr - 1, nc) + isSet(s.hydrophobic, nr + 1, nc) +
+                          isSet(s.hydrophobic, nr, nc - 1) + isSet(s.hydrophobic, nr, nc + 1));
+            s.hydrophobic[nr] |= 1ull << nc;
+        }
+        s.occupied[nr] |= 1ull << nc;
+        dfs(s, k + 1, nr, nc, d, turned || m != FORWARD, score + gained);
+        s.occupied[nr] &= ~(1ull << nc);
+        s.hydrophobic[nr] &= ~(1ull << nc);
+    }
+}
+
+// Collects every self avoiding starting walk of splitDepth moves, following the same rules as dfs()
+void collectPieces(vector<char> &grid, int depth, int pos, int dir, bool turned, vector<unsigned char> &current) {
+    if ((int) current.size() == depth) {
+        pieces.insert(pieces.end(), current.begin(), current.end());
+        numPieces++;
+        return;
+    }
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        if (!turned && m == RIGHT) continue;
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + rowStep[d] * gridSize + colStep[d];
+        if (grid[next]) continue;
+        grid[next] = 1;
+        current.push_back(m);
+        collectPieces(grid, depth, next, d, turned || m != FORWARD, current);
+        current.pop_back();
+        grid[next] = 0;
+    }
+}
+
+// Places one residue on the boards and returns the contacts it made
+int place(Search &s, int k, int r, int c) {
+    int gained = 0;
+    if (prototein[k] == 'H') {
+        gained = 2 * (isSet(s.hydrophobic, r - 1, c) + isSet(s.hydrophobic, r + 1, c) +
+                      isSet(s.hydrophobic, r, c - 1) + isSet(s.hydrophobic, r, c + 1));
+        s.hydrophobic[r] |= 1ull << c;
+    }
+    s.occupied[r] |= 1ull << c;
+    return gained;
+}
+
+void *parallel_func(void *){
+    Search s;
+    s.best = -1;
+    s.nodes = 0;
+    s.checks = 0;
+    s.pruned = 0;
+
+    while (true) {
+        pthread_mutex_lock(&mutex);
+        int piece = nextPiece++;
+        pthread_mutex_unlock(&mutex);
+        if (piece >= numPieces) break;
+
+        memset(s.occupied, 0, sizeof(s.occupied));
+        memset(s.hydrophobic, 0, sizeof(s.hydrophobic));
+
+        // Replaying the starting walk: residue 0 in the middle, residue 1 north of it, then the piece's moves
+        int r = protoLen;
+        int c = protoLen;
+        int dir = NORTH;
+        bool turned = false;
+        int score = place(s, 0, r, c);
+        int k = 1;
+        if (protoLen > 1) {
+            r--;
+            score += place(s, 1, r, c);
+            k = 2;
+        }
+        const unsigned char *moves = pieces.data() + (size_t) piece * splitDepth;
+        for (int i = 0; i < splitDepth; i++) {
+            if (moves[i] == LEFT) dir = (dir + 3) % 4;
+            if (moves[i] == RIGHT) dir = (dir + 1) % 4;
+            turned = turned || moves[i] != FORWARD;
+            r += rowStep[dir];
+            c += colStep[dir];
+            score += place(s, k, r, c);
+            k++;
+        }
+
+        dfs(s, k, r, c, dir, turned, score);
+    }
+
+    // These mutex's are required for this function to be thread safe. Should not really impact performance because its only called 20 times.
+    pthread_mutex_lock(&mutex);
+    if (s.best > maximum) maximum = s.best;
+    totalNodes += s.nodes;
+    totalChecks += s.checks;
+    totalPruned += s.pruned;
+    pthread_mutex_unlock(&mutex);
+
+    pthread_exit(NULL);
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <prototein> [prune]" << endl;
+        return 1;
+    }
+    prototein = argv[1];
+    protoLen = strlen(argv[1]);
+    if (protoLen > MAXLEN) {
+        cout << "This program handles protoeins up to " << MAXLEN << " long" << endl;
+        return 1;
+    }
+    if (argc > 2 && strcmp(argv[2], "prune") == 0) pruning = true;
+
+    gridSize = (2 * protoLen) + 1;
+    rowMask = (gridSize >= 64) ? ~0ull : ((1ull << gridSize) - 1);
+    evenColour = 0x5555555555555555ull;
+    buildSplits();
+
+    pthread_mutex_init(&mutex, 0);
+    unsigned long long start = rdtsc();
+
+    // Splitting the work into starting walks, deep enough that every thread has plenty to pull from
+    vector<char> grid(gridSize * gridSize, 0);
+    int center = protoLen * gridSize + protoLen;
+    grid[center] = 1;
+    grid[center - gridSize] = 1;
+    splitDepth = 0;
+    numPieces = 1;
+    while (splitDepth < protoLen - 2 && numPieces < NUMTHREADS * PIECES_PER_THREAD) {
+        splitDepth++;
+        pieces.clear();
+        numPieces = 0;
+        vector<unsigned char> current;
+        collectPieces(grid, splitDepth, center - gridSize, NORTH, false, current);
+    }
+
+    pthread_t threads[NUMTHREADS];
+    // Creating the threads
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, parallel_func, NULL);
+    }
+
+    // Waiting for the threads to finish
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    unsigned long long stop = rdtsc();
+
+    cout << maximum << " " << stop - start << endl;
+    cerr << "nodes: " << totalNodes << " room checks: " << totalChecks << " subtrees pruned: " << totalPruned << endl;
+
+    pthread_mutex_destroy(&mutex);
+}
@@ -0,0 +1,364 @@
+/*
+This is a program that works the problem backwards: instead of finding the best fold for one prototein, it finds every
+prototein of a given length that has exactly one best fold (a unique ground state), and how far ahead of the next best
+fold that one is (the energy gap). Optionally it only reports the proteins whose unique best fold is a fold you give it.
+
+Doing this with the other programs would mean one full run per prototein, 2^n runs. Instead the folds are enumerated
+once. Only their contact maps are kept, meaning which pairs of residues end up next to each other without being
+bonded. Two residues can only touch if one is at an even position and the other at an odd one, and they have to be at
+least 3 apart, so for n up to 32 a contact map fits in a 256 bit mask. Folds with the same contact map score the same
+for every prototein, so each map is stored once along with how many folds have it. A prototein whose best map is
+shared by two folds can't have a unique ground state. The prototein side is just as small: the pairs where both
+residues are H. Scoring a fold is then four popcounts.
+
+The maps are sorted by number of contacts, biggest first, so each prototein can stop as soon as the maps that are left
+are too small to matter. The 2^n proteins are split across 20 threads. A prototein and its reverse have the same
+answer (the reversed fold), so only the one that's smaller as a binary number (H is 1, residue i is bit i) gets
+screened, and its line stands for the reverse too. With a target fold every prototein gets screened, since the
+reverse of a design for the target is a design for the reversed fold, not the target.
+
+Like the optimized versions every fold starts by going north, and the first turn is always a left (a fold whose first
+turn is a right is the mirror image of one that turns left). The maximum and gap are printed in the same units as the
+other programs, where every H-H contact counts twice.
+
+Usage: Sequence_Design_Prototein <length> [target fold in F/L/R notation]
+Output: one "<prototein> <maximum> <gap> <fold>" line per designable prototein, then "<count> <clock cycles>". Without
+a target each line also stands for the reversed prototein, which folds into the reversed fold.
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <cstdint>
+using namespace std;
+
+#define FORWARD 0
+#define LEFT 1
+#define RIGHT 2
+
+#define WEST 0
+#define NORTH 1
+#define EAST 2
+#define SOUTH 3
+
+#define NUMTHREADS 20
+#define MAXLEN 32
+
+struct ContactMap {
+    uint64_t bits[4];
+    bool operator==(const ContactMap &other) const {
+        return memcmp(bits, other.bits, sizeof(bits)) == 0;
+    }
+};
+
+struct MapHash {
+    size_t operator()(const ContactMap &m) const {
+        uint64_t h = m.bits[0] * 0x9E3779B97F4A7C15ull;
+        h ^= m.bits[1] + (h << 6) + (h >> 2);
+        h ^= m.bits[2] + (h << 6) + (h >> 2);
+        h ^= m.bits[3] + (h << 6) + (h >> 2);
+        return h;
+    }
+};
+
+// One distinct contact map, how many folds share it, and one of those folds (2 bits per move)
+struct FoldClass {
+    ContactMap map;
+    int contacts;
+    int folds;
+    uint64_t moves;
+};
+
+struct Design {
+    string prototein;
+    int maximum;
+    int gap;
+    string fold;
+};
+
+// Initializing global variables
+int protoLen;
+int pairIndex[MAXLEN][MAXLEN];
+vector<FoldClass> classes;
+unordered_map<ContactMap, int, MapHash> classOf;
+int targetClass = -1;
+vector<Design> designs[NUMTHREADS];
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+// Gives every pair of residues that could ever touch its own bit
+void buildPairIndex() {
+    int next = 0;
+    for (int i = 0; i < protoLen; i++) {
+        for (int j = 0; j < protoLen; j++) {
+            pairIndex[i][j] = -1;
+        }
+    }
+    for (int i = 0; i < protoLen; i++) {
+        for (int j = i + 3; j < protoLen; j += 2) {
+            pairIndex[i][j] = next;
+            pairIndex[j][i] = next;
+            next++;
+        }
+    }
+}
+
+string movesToFold(uint64_t moves) {
+    string fold = "";
+    for (int i = 0; i < protoLen - 1; i++) {
+        fold += "FLR"[(moves >> (2 * i)) & 3];
+    }
+    return fold;
+}
+
+// Adds a finished fold to its contact map's class
+void recordFold(const ContactMap &map, int contacts, uint64_t moves) {
+    unordered_map<ContactMap, int, MapHash>::iterator it = classOf.find(map);
+    if (it == classOf.end()) {
+        FoldClass c;
+        c.map = map;
+        c.contacts = contacts;
+        c.folds = 1;
+        c.moves = moves;
+        classOf[map] = classes.size();
+        classes.push_back(c);
+    } else {
+        classes[it->second].folds++;
+    }
+}
+
+// Depth first enumeration of every fold. grid holds residue index + 1, 0 is empty.
+void enumerate(vector<int> &grid, int size, int k, int pos, int dir, bool turned, ContactMap &map, int contacts,
+               uint64_t moves) {
+    if (k == protoLen) {
+        // The straight line and anything else with no contacts scores 0 for every prototein, no need to keep it
+        if (contacts > 0) recordFold(map, contacts, moves);
+        return;
+    }
+
+    const int step[4] = {-1, -size, 1, size};
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        if (!turned && m == RIGHT) continue;
+
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + step[d];
+        if (grid[next] != 0) continue;
+
+        // New contacts are with any placed residue next door other than the one we came from
+        ContactMap newMap = map;
+        int newContacts = contacts;
+        for (int n = 0; n < 4; n++) {
+            int other = grid[next + step[n]] - 1;
+            if (other < 0 || other == k - 1) continue;
+            int bit = pairIndex[other][k];
+            newMap.bits[bit >> 6] |= 1ull << (bit & 63);
+            newContacts++;
+        }
+
+        grid[next] = k + 1;
+        enumerate(grid, size, k + 1, next, d, turned || m != FORWARD, newMap, newContacts,
+                  moves | ((uint64_t) m << (2 * (k - 1))));
+        grid[next] = 0;
+    }
+}
+
+// Works out the contact map of a fold given in F/L/R notation. Returns false if it isn't a self avoiding fold.
+bool foldToMap(string fold, ContactMap &map) {
+    if ((int) fold.size() != protoLen - 1) return false;
+
+    // Folds are only stored with a left as the first turn, so mirror the target if it turns right first
+    size_t firstTurn = fold.find_first_not_of('F');
+    if (firstTurn != string::npos && fold[firstTurn] == 'R') {
+        for (size_t i = 0; i < fold.size(); i++) {
+            if (fold[i] == 'L') fold[i] = 'R';
+            else if (fold[i] == 'R') fold[i] = 'L';
+        }
+    }
+
+    int size = (2 * protoLen) + 1;
+    const int step[4] = {-1, -size, 1, size};
+    vector<int> grid(size * size, 0);
+    memset(map.bits, 0, sizeof(map.bits));
+
+    int pos = protoLen * size + protoLen;
+    int dir = NORTH;
+    grid[pos] = 1;
+    for (int k = 1; k < protoLen; k++) {
+        char m = fold[k - 1];
+        if (m == 'L') dir = (dir + 3) % 4;
+        else if (m == 'R') dir = (dir + 1) % 4;
+        else if (m != 'F') return false;
+        pos += step[dir];
+        if (grid[pos] != 0) return false;
+        for (int n = 0; n < 4; n++) {
+            int other = grid[pos + step[n]] - 1;
+            if (other < 0 || other == k - 1) continue;
+            int bit = pairIndex[other][k];
+            map.bits[bit >> 6] |= 1ull << (bit & 63);
+        }
+        grid[pos] = k + 1;
+    }
+    return true;
+}
+
+bool compareClasses(const FoldClass &a, const FoldClass &b) {
+    return a.contacts > b.contacts;
+}
+
+void *parallel_func(void *threadid){
+    uintptr_t tid = reinterpret_cast<uintptr_t>(threadid);
+    long long numProteins = 1ll << protoLen;
+    long long segmentSize = numProteins / NUMTHREADS;
+    long long startPos = segmentSize * tid;
+    long long stopPos = (tid < (NUMTHREADS - 1)) ? segmentSize * (tid + 1) - 1 : numProteins - 1;
+
+    for (long long p = startPos; p <= stopPos; p++) {
+        // Bit i set means residue i is an H. Without a target only the canonical one of each prototein/reverse pair is
+        // screened, with one the reverse would be matched against the wrong fold so both get screened.
+        long long reversed = 0;
+        for (int i = 0; i < protoLen; i++) {
+            if ((p >> i) & 1) reversed |= 1ll << (protoLen - 1 - i);
+        }
+        if (targetClass == -1 && reversed < p) continue;
+
+        ContactMap hh;
+        memset(hh.bits, 0, sizeof(hh.bits));
+        int hCount = 0;
+        for (int i = 0; i < protoLen; i++) {
+            if (!((p >> i) & 1)) continue;
+            hCount++;
+            for (int j = i + 3; j < protoLen; j += 2) {
+                if ((p >> j) & 1) {
+                    int bit = pairIndex[i][j];
+                    hh.bits[bit >> 6] |= 1ull << (bit & 63);
+                }
+            }
+        }
+        if (hCount < 2) continue;
+
+        // best and second are in contacts. Folds with no contacts always exist (the straight line), so second starts at 0.
+        int best = 0;
+        int bestFolds = 0;
+        int bestClass = -1;
+        int second = 0;
+        for (size_t c = 0; c < classes.size(); c++) {
+            // Maps are sorted biggest first, so once a map can't beat second place nothing after it can either
+            if (classes[c].contacts <= second) break;
+
+            const uint64_t *a = classes[c].map.bits;
+            int s = __builtin_popcountll(a[0] & hh.bits[0]) + __builtin_popcountll(a[1] & hh.bits[1]) +
+                    __builtin_popcountll(a[2] & hh.bits[2]) + __builtin_popcountll(a[3] & hh.bits[3]);
+            if (s > best) {
+                second = best;
+                best = s;
+                bestFolds = classes[c].folds;
+                bestClass = c;
+            } else if (s == best) {
+                bestFolds += classes[c].folds;
+            } else if (s > second) {
+                second = s;
+            }
+
+            // Already tied for first, there's no unique ground state
+            if (bestFolds > 1 && classes[c].contacts <= best) break;
+        }
+
+        if (bestClass == -1 || bestFolds != 1) continue;
+        if (targetClass != -1 && bestClass != targetClass) continue;
+
+        Design d;
+        d.prototein = "";
+        int bondedHH = 0;
+        for (int i = 0; i < protoLen; i++) {
+            d.prototein += ((p >> i) & 1) ? 'H' : 'P';
+            if (i > 0 && ((p >> i) & 1) && ((p >> (i - 1)) & 1)) bondedHH++;
+        }
+        d.maximum = 2 * (best + bondedHH);
+        d.gap = 2 * (best - second);
+        d.fold = movesToFold(classes[bestClass].moves);
+        designs[tid].push_back(d);
+    }
+
+    pthread_exit(NULL);
+}
+
+bool compareDesigns(const Design &a, const Design &b) {
+    if (a.gap != b.gap) return a.gap > b.gap;
+    return a.prototein < b.prototein;
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <length> [target fold in F/L/R notation]" << endl;
+        return 1;
+    }
+    protoLen = atoi(argv[1]);
+    if (protoLen < 4 || protoLen > MAXLEN) {
+        cout << "Length has to be between 4 and " << MAXLEN << endl;
+        return 1;
+    }
+    buildPairIndex();
+
+    unsigned long long start = rdtsc();
+
+    // Enumerating every fold once
+    int size = (2 * protoLen) + 1;
+    vector<int> grid(size * size, 0);
+    int center = protoLen * size + protoLen;
+    ContactMap empty;
+    memset(empty.bits, 0, sizeof(empty.bits));
+    grid[center] = 1;
+    grid[center - size] = 2;
+    enumerate(grid, size, 2, center - size, NORTH, false, empty, 0, 0);
+    sort(classes.begin(), classes.end(), compareClasses);
+
+    if (argc > 2) {
+        ContactMap target;
+        if (!foldToMap(argv[2], target)) {
+            cout << "Target fold has to be " << protoLen - 1 << " self avoiding F/L/R moves" << endl;
+            return 1;
+        }
+        for (size_t c = 0; c < classes.size(); c++) {
+            if (classes[c].map == target) targetClass = c;
+        }
+        // A fold with no contacts can never be the unique best fold
+        if (targetClass == -1) {
+            unsigned long long stop = rdtsc();
+            cout << 0 << " " << stop - start << endl;
+            return 0;
+        }
+    }
+
+    pthread_t threads[NUMTHREADS];
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, parallel_func, (void *)t);
+    }
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    unsigned long long stop = rdtsc();
+
+    vector<Design> all;
+    for (int t = 0; t < NUMTHREADS; t++) {
+        all.insert(all.end(), designs[t].begin(), designs[t].end());
+    }
+    sort(all.begin(), all.end(), compareDesigns);
+    for (size_t i = 0; i < all.size(); i++) {
+        cout << all[i].prototein << " " << all[i].maximum << " " << all[i].gap << " " << all[i].fold << endl;
+    }
+    cout << all.size() << " " << stop - start << endl;
+    if (targetClass == -1) cerr << "each prototein also stands for its reverse, with the fold reversed" << endl;
+}
@@ -0,0 +1,689 @@
+/*
+This is a program that estimates the density of states of a prototein, g(E), meaning what fraction of all of its folds
+have each energy, for proteins far too long to enumerate. The energy of a fold is minus its number of H-H contacts
+between residues that aren't bonded. From g(E) it works out the energy, heat capacity, free energy and entropy over a
+range of temperatures.
+
+It's a Wang-Landau sampler: a random walk through folds that accepts a move from energy E to E' with probability
+g(E)/g(E'), using its current guess at g. Every visit to an energy raises the guess for it by a factor f, so energies
+that have been visited a lot get harder to reach and the walk spreads out over every energy. Once the histogram of
+visits is flat (every energy visited at least FLATNESS times the average), f is square rooted and the histogram is
+reset, until ln f is below the final value.
+
+Moves:
+    end move     an end residue moves to another free cell next to its neighbour
+    corner flip  a residue at a corner jumps to the opposite corner of the square its neighbours make
+    crankshaft   a residue and the next one, forming a U with the residues either side, flip to the other side
+    pivot        the shorter end of the chain past a random residue gets rotated or reflected around it
+Contact counts are updated from just what moved: the old and new neighbours of the moved residues, and for a pivot the
+contacts between the part that moved and the part that didn't.
+
+The energy range is split into overlapping windows, with the 20 threads shared out between them. Each thread walks
+only inside its window, and the threads in a window merge their guesses (averaging ln g) and add up their histograms
+every round. The flatness check is done on the merged histogram, and only over energies the window has actually
+reached, since the lowest energies in the range may not exist at all. At the end the windows are stitched together by
+matching ln g where they overlap.
+
+To get every window started, every thread first does a quick Wang-Landau walk over the whole range from a straight
+chain and saves a fold for every number of contacts it reaches. The highest number of contacts any of them reached is
+the top of the range.
+
+Passing "validate" (up to VALIDATE_MAXLEN residues) also enumerates every fold exactly and prints the exact ln g next
+to the estimate.
+
+Usage: Wang_Landau_Prototein <prototein> [final ln f, default 1e-6] [windows, default 4] [validate]
+Output: "density" then one "<energy> <ln g>" line per energy (g as a fraction of all folds), "thermodynamics" then one
+"<temperature> <energy> <heat capacity> <free energy> <entropy>" line per temperature, and with validate, "validation"
+then "<energy> <exact ln g> <estimated ln g>" lines and the biggest difference. Last comes
+"<lowest energy found> <clock cycles>".
+
+@author: Owen Sheed
+*/
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <cstdint>
+using namespace std;
+
+#define FORWARD 0
+#define LEFT 1
+#define RIGHT 2
+
+#define WEST 0
+#define NORTH 1
+#define EAST 2
+#define SOUTH 3
+
+#define NUMTHREADS 20
+#define MAXLEN 128
+
+// Walkers live on a wrapped 256x256 grid, more than a chain of MAXLEN can span
+#define TORUS 256
+
+#define FLATNESS 0.8
+#define DEFAULT_FINAL_LNF 1e-6
+#define DEFAULT_WINDOWS 4
+
+// Steps each walker takes between merges, and in the starting walk over the whole range
+#define ROUND_STEPS 100000
+#define PRERUN_STEPS 1000000
+
+// Every thread gives up after this many rounds, so a window that can't get flat doesn't run forever
+#define MAX_ROUNDS 100000
+
+// Out of 16, how often a move is a pivot
+#define PIVOT_CHANCE 2
+
+#define VALIDATE_MAXLEN 20
+
+// Temperatures for the thermodynamic curves
+#define THERMO_LOWEST 0.05
+#define THERMO_STEP 0.05
+#define THERMO_COUNT 40
+
+struct Walker {
+    int x[MAXLEN];
+    int y[MAXLEN];
+    vector<short> grid;
+    int contacts;
+    uint64_t rng;
+    int window;
+    vector<double> lng;
+    vector<long long> hist;
+    int moved[MAXLEN];
+    int newX[MAXLEN];
+    int newY[MAXLEN];
+};
+
+// A saved fold with a known number of contacts
+struct Snapshot {
+    bool saved;
+    int x[MAXLEN];
+    int y[MAXLEN];
+};
+
+// Initializing global variables
+char *prototein;
+int protoLen;
+int topBound;
+int topContacts = 0;
+double finalLnf = DEFAULT_FINAL_LNF;
+int numWindows = DEFAULT_WINDOWS;
+vector<int> windowLow;
+vector<int> windowHigh;
+vector<double> windowLnf;
+vector<char> windowDone;
+vector<vector<double> > windowLng;
+vector<Snapshot> snapshots;
+Walker *walkers[NUMTHREADS];
+pthread_mutex_t mutex;
+pthread_barrier_t barrier;
+
+// West, north, east, south with y going up
+const int dx[4] = {-1, 0, 1, 0};
+const int dy[4] = {0, 1, 0, -1};
+
+// This function is purely for runtime analysis and is not needed for the program to work
+unsigned long long rdtsc() {
+   unsigned hi, lo;
+   __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+   return ((unsigned long long) lo) | (((unsigned long long) hi) << 32);
+}
+
+uint64_t splitmix(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+inline uint64_t nextRandom(uint64_t &state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1Dull;
+}
+
+inline double uniform(uint64_t &state) {
+    return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+inline int cellOf(int x, int y) {
+    return ((y & (TORUS - 1)) * TORUS) + (x & (TORUS - 1));
+}
+
+// Residue at a cell, -1 if it's empty
+inline int residueAt(const Walker &w, int x, int y) {
+    return w.grid[cellOf(x, y)] - 1;
+}
+
+// Non-bonded H neighbours residue r would have at (x, y), skipping residues that aren't on the grid
+inline int hContacts(const Walker &w, int r, int x, int y) {
+    int count = 0;
+    for (int d = 0; d < 4; d++) {
+        int j = residueAt(w, x + dx[d], y + dy[d]);
+        if (j >= 0 && prototein[j] == 'H' && abs(j - r) != 1) count++;
+    }
+    return count;
+}
+
+// Most non-bonded contacts any fold could have, from the same parity bound as my beam search
+int contactBound() {
+    int total = 0;
+    for (int j = 1; j < protoLen; j++) {
+        if (prototein[j] != 'H') continue;
+        int otherParity = 0;
+        for (int i = (j % 2 == 0) ? 1 : 0; i < j - 1; i += 2) {
+            if (prototein[i] == 'H') otherParity++;
+        }
+        total += min(j == protoLen - 1 ? 3 : 2, otherParity);
+    }
+    return total;
+}
+
+void setFold(Walker &w, const int *xs, const int *ys) {
+    fill(w.grid.begin(), w.grid.end(), 0);
+    for (int i = 0; i < protoLen; i++) {
+        w.x[i] = xs[i];
+        w.y[i] = ys[i];
+        w.grid[cellOf(xs[i], ys[i])] = i + 1;
+    }
+    w.contacts = 0;
+    for (int i = 0; i < protoLen; i++) {
+        if (prototein[i] == 'H') w.contacts += hContacts(w, i, w.x[i], w.y[i]);
+    }
+    w.contacts /= 2;
+}
+
+inline void moveResidue(Walker &w, int r, int x, int y) {
+    w.grid[cellOf(w.x[r], w.y[r])] = 0;
+    w.grid[cellOf(x, y)] = r + 1;
+    w.x[r] = x;
+    w.y[r] = y;
+}
+
+// How far a number of contacts is from [low, high], 0 inside it
+inline int outside(int contacts, int low, int high) {
+    return contacts < low ? low - contacts : (contacts > high ? contacts - high : 0);
+}
+
+// Wang-Landau acceptance for going from the current number of contacts to proposed, inside [low, high]. A walker that
+// started outside its window takes any move that doesn't take it further away, until it gets in.
+inline bool accept(Walker &w, int proposed, int low, int high) {
+    int distance = outside(w.contacts, low, high);
+    if (distance > 0) return outside(proposed, low, high) <= distance;
+    if (proposed < low || proposed > high) return false;
+    double diff = w.lng[w.contacts] - w.lng[proposed];
+    return diff >= 0 || uniform(w.rng) < exp(diff);
+}
+
+// Moving one residue to (nx, ny): contacts lost at the old cell and gained at the new one
+inline int singleChange(Walker &w, int r, int nx, int ny) {
+    if (prototein[r] != 'H') return 0;
+    short saved = w.grid[cellOf(w.x[r], w.y[r])];
+    w.grid[cellOf(w.x[r], w.y[r])] = 0;
+    int change = hContacts(w, r, nx, ny) - hContacts(w, r, w.x[r], w.y[r]);
+    w.grid[cellOf(w.x[r], w.y[r])] = saved;
+    return change;
+}
+
+void localMove(Walker &w, int low, int high) {
+    int i = nextRandom(w.rng) % protoLen;
+    int x = w.x[i];
+    int y = w.y[i];
+
+    if (i == 0 || i == protoLen - 1) {
+        int n = (i == 0) ? 1 : protoLen - 2;
+        int d = nextRandom(w.rng) % 4;
+        int nx = w.x[n] + dx[d];
+        int ny = w.y[n] + dy[d];
+        if (residueAt(w, nx, ny) >= 0) return;
+        int proposed = w.contacts + singleChange(w, i, nx, ny);
+        if (!accept(w, proposed, low, high)) return;
+        moveResidue(w, i, nx, ny);
+        w.contacts = proposed;
+        return;
+    }
+
+    int px = w.x[i - 1];
+    int py = w.y[i - 1];
+    int qx = w.x[i + 1];
+    int qy = w.y[i + 1];
+    if (px == qx || py == qy) return;
+
+    if ((nextRandom(w.rng) & 1) == 0 || i + 2 >= protoLen) {
+        int nx = px + qx - x;
+        int ny = py + qy - y;
+        if (residueAt(w, nx, ny) >= 0) return;
+        int proposed = w.contacts + singleChange(w, i, nx, ny);
+        if (!accept(w, proposed, low, high)) return;
+        moveResidue(w, i, nx, ny);
+        w.contacts = proposed;
+        return;
+    }
+
+    // Crankshaft on i and i + 1
+    int j = i + 1;
+    int x2 = w.x[j];
+    int y2 = w.y[j];
+    if (abs(px - w.x[i + 2]) + abs(py - w.y[i + 2]) != 1) return;
+    if (abs(x - x2) + abs(y - y2) != 1) return;
+    int ox = 2 * (px - x);
+    int oy = 2 * (py - y);
+    if (residueAt(w, x + ox, y + oy) >= 0 || residueAt(w, x2 + ox, y2 + oy) >= 0) return;
+
+    // Both come off the grid while counting, so neither sees the other
+    w.grid[cellOf(x, y)] = 0;
+    w.grid[cellOf(x2, y2)] = 0;
+    int change = 0;
+    if (prototein[i] == 'H') change += hContacts(w, i, x + ox, y + oy) - hContacts(w, i, x, y);
+    if (prototein[j] == 'H') change += hContacts(w, j, x2 + ox, y2 + oy) - hContacts(w, j, x2, y2);
+    w.grid[cellOf(x, y)] = i + 1;
+    w.grid[cellOf(x2, y2)] = j + 1;
+
+    int proposed = w.contacts + change;
+    if (!accept(w, proposed, low, high)) return;
+    moveResidue(w, i, x + ox, y + oy);
+    moveResidue(w, j, x2 + ox, y2 + oy);
+    w.contacts = proposed;
+}
+
+// The 7 rotations and reflections of the square lattice, applied to an offset
+inline void transform(int t, int ox, int oy, int &rx, int &ry) {
+    switch (t) {
+        case 0: rx = -oy; ry = ox; break;
+        case 1: rx = -ox; ry = -oy; break;
+        case 2: rx = oy; ry = -ox; break;
+        case 3: rx = -ox; ry = oy; break;
+        case 4: rx = ox; ry = -oy; break;
+        case 5: rx = oy; ry = ox; break;
+        default: rx = -oy; ry = -ox; break;
+    }
+}
+
+void pivotMove(Walker &w, int low, int high) {
+    if (protoLen < 3) return;
+    int p = 1 + nextRandom(w.rng) % (protoLen - 2);
+    int t = nextRandom(w.rng) % 7;
+
+    // The shorter side moves: residues from first to last
+    int first = (p < protoLen / 2) ? 0 : p + 1;
+    int last = (p < protoLen / 2) ? p - 1 : protoLen - 1;
+    int count = 0;
+    int oldCross = 0;
+    int newCross = 0;
+    for (int r = first; r <= last; r++) {
+        int rx, ry;
+        transform(t, w.x[r] - w.x[p], w.y[r] - w.y[p], rx, ry);
+        int nx = w.x[p] + rx;
+        int ny = w.y[p] + ry;
+        // Landing on a residue that stays put is a clash, landing on one that's moving isn't
+        int there = residueAt(w, nx, ny);
+        if (there >= 0 && (there < first || there > last)) return;
+        w.moved[count] = r;
+        w.newX[count] = nx;
+        w.newY[count] = ny;
+        count++;
+    }
+
+    // Only contacts between the moving and fixed parts can change
+    for (int k = 0; k < count; k++) {
+        int r = w.moved[k];
+        if (prototein[r] != 'H') continue;
+        for (int d = 0; d < 4; d++) {
+            int j = residueAt(w, w.x[r] + dx[d], w.y[r] + dy[d]);
+            if (j >= 0 && (j < first || j > last) && prototein[j] == 'H' && abs(j - r) != 1) oldCross++;
+            j = residueAt(w, w.newX[k] + dx[d], w.newY[k] + dy[d]);
+            if (j >= 0 && (j < first || j > last) && prototein[j] == 'H' && abs(j - r) != 1) newCross++;
+        }
+    }
+
+    int proposed = w.contacts + newCross - oldCross;
+    if (!accept(w, proposed, low, high)) return;
+    for (int k = 0; k < count; k++) w.grid[cellOf(w.x[w.moved[k]], w.y[w.moved[k]])] = 0;
+    for (int k = 0; k < count; k++) {
+        int r = w.moved[k];
+        w.x[r] = w.newX[k];
+        w.y[r] = w.newY[k];
+        w.grid[cellOf(w.x[r], w.y[r])] = r + 1;
+    }
+    w.contacts = proposed;
+}
+
+// One Wang-Landau step inside [low, high]. Nothing is counted until the walker is inside.
+inline void step(Walker &w, int low, int high, double lnf) {
+    if ((int) (nextRandom(w.rng) & 15) < PIVOT_CHANCE) pivotMove(w, low, high);
+    else localMove(w, low, high);
+    if (w.contacts < low || w.contacts > high) return;
+    w.lng[w.contacts] += lnf;
+    w.hist[w.contacts]++;
+}
+
+// The window a thread works in, and whether it merges for that window
+inline int windowOf(int tid) {
+    return tid % numWindows;
+}
+
+// Merges a window's walkers: averaging ln g, adding up the histograms and checking if they're flat
+void mergeWindow(int window) {
+    int low = windowLow[window];
+    int high = windowHigh[window];
+    vector<double> lng(topBound + 1, 0.0);
+    vector<long long> hist(topBound + 1, 0);
+    int members = 0;
+    for (int t = 0; t < NUMTHREADS; t++) {
+        if (windowOf(t) != window) continue;
+        members++;
+        for (int c = low; c <= high; c++) {
+            lng[c] += walkers[t]->lng[c];
+            hist[c] += walkers[t]->hist[c];
+        }
+    }
+    for (int c = low; c <= high; c++) lng[c] /= members;
+
+    // Only energies this window has ever reached count toward flatness
+    long long total = 0;
+    long long lowest = -1;
+    int reached = 0;
+    for (int c = low; c <= high; c++) {
+        if (lng[c] <= 0) continue;
+        reached++;
+        total += hist[c];
+        if (lowest < 0 || hist[c] < lowest) lowest = hist[c];
+    }
+    bool flat = reached > 0 && lowest >= FLATNESS * ((double) total / reached);
+
+    for (int t = 0; t < NUMTHREADS; t++) {
+        if (windowOf(t) != window) continue;
+        for (int c = low; c <= high; c++) {
+            walkers[t]->lng[c] = lng[c];
+            if (flat) walkers[t]->hist[c] = 0;
+        }
+    }
+    windowLng[window] = lng;
+    if (flat) {
+        windowLnf[window] /= 2;
+        if (windowLnf[window] < finalLnf) windowDone[window] = true;
+    }
+}
+
+// A quick walk over every energy from a straight chain, saving a fold for each number of contacts reached
+void *prerun_func(void *threadid){
+    uintptr_t tid = reinterpret_cast<uintptr_t>(threadid);
+    Walker &w = *walkers[tid];
+    vector<Snapshot> found(topBound + 1);
+    for (int c = 0; c <= topBound; c++) found[c].saved = false;
+
+    for (long long s = 0; s < PRERUN_STEPS; s++) {
+        step(w, 0, topBound, 1.0);
+        Snapshot &snap = found[w.contacts];
+        if (!snap.saved) {
+            snap.saved = true;
+            memcpy(snap.x, w.x, sizeof(w.x));
+            memcpy(snap.y, w.y, sizeof(w.y));
+        }
+    }
+
+    pthread_mutex_lock(&mutex);
+    for (int c = 0; c <= topBound; c++) {
+        if (found[c].saved && !snapshots[c].saved) snapshots[c] = found[c];
+        if (found[c].saved) topContacts = max(topContacts, c);
+    }
+    pthread_mutex_unlock(&mutex);
+
+    pthread_exit(NULL);
+}
+
+void *parallel_func(void *threadid){
+    uintptr_t tid = reinterpret_cast<uintptr_t>(threadid);
+    Walker &w = *walkers[tid];
+    int window = windowOf(tid);
+    int low = windowLow[window];
+    int high = windowHigh[window];
+    // The first thread in each window does its merging
+    bool leader = ((int) tid == window);
+
+    for (int round = 0; round < MAX_ROUNDS; round++) {
+        if (!windowDone[window]) {
+            double lnf = windowLnf[window];
+            for (int s = 0; s < ROUND_STEPS; s++) step(w, low, high, lnf);
+        }
+        pthread_barrier_wait(&barrier);
+        if (leader && !windowDone[window]) mergeWindow(window);
+        pthread_barrier_wait(&barrier);
+
+        bool allDone = true;
+        for (int i = 0; i < numWindows; i++) allDone = allDone && windowDone[i];
+        if (allDone) break;
+    }
+
+    pthread_exit(NULL);
+}
+
+// Exact count of folds per number of contacts, weighted so the one-per-symmetry enumeration counts every fold
+void enumerate(vector<int> &grid, int size, int k, int pos, int dir, bool turned, int contacts,
+               vector<double> &counts) {
+    if (k == protoLen) {
+        // A fold that never turns only has 4 copies, the rest have 8
+        counts[contacts] += turned ? 8 : 4;
+        return;
+    }
+    const int step[4] = {-1, -size, 1, size};
+    for (int m = FORWARD; m <= RIGHT; m++) {
+        if (!turned && m == RIGHT) continue;
+        int d = dir;
+        if (m == LEFT) d = (dir + 3) % 4;
+        if (m == RIGHT) d = (dir + 1) % 4;
+        int next = pos + step[d];
+        if (grid[next] != 0) continue;
+        int gained = 0;
+        if (prototein[k] == 'H') {
+            for (int n = 0; n < 4; n++) {
+                int other = grid[next + step[n]] - 1;
+                if (other >= 0 && other != k - 1 && prototein[other] == 'H') gained++;
+            }
+        }
+        grid[next] = k + 1;
+        enumerate(grid, size, k + 1, next, d, turned || m != FORWARD, contacts + gained, counts);
+        grid[next] = 0;
+    }
+}
+
+// ln of the sum of exp of the values that are set
+double logSum(const vector<double> &values, const vector<bool> &set) {
+    double top = -1e300;
+    for (size_t i = 0; i < values.size(); i++) if (set[i]) top = max(top, values[i]);
+    double sum = 0;
+    for (size_t i = 0; i < values.size(); i++) if (set[i]) sum += exp(values[i] - top);
+    return top + log(sum);
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " <prototein> [final ln f] [windows] [validate]" << endl;
+        return 1;
+    }
+    prototein = argv[1];
+    protoLen = strlen(argv[1]);
+    if (protoLen < 2 || protoLen > MAXLEN) {
+        cout << "This program handles protoeins from 2 to " << MAXLEN << " long" << endl;
+        return 1;
+    }
+    bool validate = false;
+    int numbers = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "validate") == 0) validate = true;
+        else if (numbers++ == 0) finalLnf = atof(argv[i]);
+        else numWindows = max(1, min(NUMTHREADS, atoi(argv[i])));
+    }
+    if (validate && protoLen > VALIDATE_MAXLEN) {
+        cout << "Validation enumerates every fold, so it only goes up to " << VALIDATE_MAXLEN << " long" << endl;
+        return 1;
+    }
+
+    pthread_mutex_init(&mutex, 0);
+    unsigned long long start = rdtsc();
+    topBound = contactBound();
+
+    // Every walker starts as a straight chain heading east
+    vector<int> xs(protoLen), ys(protoLen, 0);
+    for (int i = 0; i < protoLen; i++) xs[i] = i;
+    for (long t = 0; t < NUMTHREADS; t++) {
+        walkers[t] = new Walker();
+        Walker &w = *walkers[t];
+        w.grid.assign(TORUS * TORUS, 0);
+        w.rng = splitmix(t + 1);
+        w.lng.assign(topBound + 1, 0.0);
+        w.hist.assign(topBound + 1, 0);
+        setFold(w, xs.data(), ys.data());
+    }
+
+    pthread_t threads[NUMTHREADS];
+    snapshots.assign(topBound + 1, Snapshot());
+    for (int c = 0; c <= topBound; c++) snapshots[c].saved = false;
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, prerun_func, (void *)t);
+    }
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    // Windows overlap by a few energies, and there can't be more of them than the range has room for
+    numWindows = max(1, min(numWindows, (topContacts + 1) / 3));
+    windowLow.assign(numWindows, 0);
+    windowHigh.assign(numWindows, 0);
+    windowLnf.assign(numWindows, 1.0);
+    windowDone.assign(numWindows, false);
+    windowLng.assign(numWindows, vector<double>());
+    for (int i = 0; i < numWindows; i++) {
+        windowLow[i] = (i * topContacts) / numWindows;
+        windowHigh[i] = min(topContacts, ((i + 1) * topContacts) / numWindows + 2);
+        if (i == numWindows - 1) windowHigh[i] = topContacts;
+    }
+
+    // Starting each walker from a saved fold as close to the middle of its window as there is
+    for (int t = 0; t < NUMTHREADS; t++) {
+        Walker &w = *walkers[t];
+        int window = windowOf(t);
+        int middle = (windowLow[window] + windowHigh[window]) / 2;
+        int pick = -1;
+        for (int c = windowLow[window]; c <= windowHigh[window]; c++) {
+            if (snapshots[c].saved && (pick < 0 || abs(c - middle) < abs(pick - middle))) pick = c;
+        }
+        // If nothing is saved inside the window, the walker starts from the nearest fold outside it and walks in
+        // (accept() lets it move towards the window freely until it gets there). A pick inside is never replaced.
+        int low = windowLow[window];
+        int high = windowHigh[window];
+        for (int c = 0; c <= topContacts; c++) {
+            if (snapshots[c].saved && (pick < 0 || outside(c, low, high) < outside(pick, low, high))) pick = c;
+        }
+        setFold(w, snapshots[pick].x, snapshots[pick].y);
+        fill(w.lng.begin(), w.lng.end(), 0.0);
+        fill(w.hist.begin(), w.hist.end(), 0);
+        w.window = window;
+    }
+
+    pthread_barrier_init(&barrier, NULL, NUMTHREADS);
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_create(&threads[t], NULL, parallel_func, (void *)t);
+    }
+    for (long t = 0; t < NUMTHREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    pthread_barrier_destroy(&barrier);
+
+    // Stitching the windows together, each one shifted to match the one below where they overlap
+    vector<double> lng(topContacts + 1, 0.0);
+    vector<bool> reached(topContacts + 1, false);
+    for (int i = 0; i < numWindows; i++) {
+        const vector<double> &mine = windowLng[i];
+        double shift = 0;
+        if (i > 0) {
+            int overlap = 0;
+            for (int c = windowLow[i]; c <= windowHigh[i - 1]; c++) {
+                if (reached[c] && mine[c] > 0) {
+                    shift += lng[c] - mine[c];
+                    overlap++;
+                }
+            }
+            if (overlap > 0) shift /= overlap;
+            else cerr << "windows " << i - 1 << " and " << i << " don't overlap, their ln g won't line up" << endl;
+        }
+        int middle = (i > 0) ? (windowLow[i] + windowHigh[i - 1]) / 2 : -1;
+        for (int c = windowLow[i]; c <= windowHigh[i]; c++) {
+            if (mine[c] <= 0) continue;
+            if (c > middle || !reached[c]) {
+                lng[c] = mine[c] + shift;
+                reached[c] = true;
+            }
+        }
+    }
+    for (int i = 0; i < numWindows; i++) {
+        if (!windowDone[i]) cerr << "window " << i << " didn't converge, ln f got to " << windowLnf[i] << endl;
+    }
+
+    // As fractions of all folds
+    double total = logSum(lng, reached);
+    int lowestEnergy = 0;
+    cout << "density" << endl;
+    for (int c = 0; c <= topContacts; c++) {
+        if (!reached[c]) continue;
+        lng[c] -= total;
+        lowestEnergy = -c;
+        cout << -c << " " << lng[c] << endl;
+    }
+
+    cout << "thermodynamics" << endl;
+    for (int k = 0; k < THERMO_COUNT; k++) {
+        double T = THERMO_LOWEST + k * THERMO_STEP;
+        vector<double> weights(topContacts + 1, 0.0);
+        for (int c = 0; c <= topContacts; c++) weights[c] = lng[c] + c / T;
+        double lnZ = logSum(weights, reached);
+        double energy = 0;
+        double energySquared = 0;
+        for (int c = 0; c <= topContacts; c++) {
+            if (!reached[c]) continue;
+            double p = exp(weights[c] - lnZ);
+            energy += -c * p;
+            energySquared += (double) c * c * p;
+        }
+        double heat = (energySquared - energy * energy) / (T * T);
+        double freeEnergy = -T * lnZ;
+        double entropy = (energy - freeEnergy) / T;
+        cout << T << " " << energy << " " << heat << " " << freeEnergy << " " << entropy << endl;
+    }
+
+    if (validate) {
+        int size = (2 * protoLen) + 1;
+        vector<int> grid(size * size, 0);
+        int center = protoLen * size + protoLen;
+        vector<double> counts(topBound + 1, 0.0);
+        grid[center] = 1;
+        grid[center - size] = 2;
+        enumerate(grid, size, 2, center - size, NORTH, false, 0, counts);
+
+        double all = 0;
+        for (int c = 0; c <= topBound; c++) all += counts[c];
+        double worst = 0;
+        cout << "validation" << endl;
+        for (int c = 0; c <= topBound; c++) {
+            if (counts[c] == 0 && (c > topContacts || !reached[c])) continue;
+            double exact = counts[c] > 0 ? log(counts[c] / all) : -INFINITY;
+            double estimate = (c <= topContacts && reached[c]) ? lng[c] : -INFINITY;
+            cout << -c << " " << exact << " " << estimate << endl;
+            worst = max(worst, fabs(exact - estimate));
+        }
+        cout << "biggest difference " << worst << endl;
+    }
+
+    unsigned long long stop = rdtsc();
+    cout << lowestEnergy << " " << stop - start << endl;
+
+    for (int t = 0; t < NUMTHREADS; t++) delete walkers[t];
+    pthread_mutex_destroy(&mutex);
+}